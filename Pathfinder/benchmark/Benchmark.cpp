@@ -0,0 +1,161 @@
+// Headless benchmark driver: builds NavMeshes over a sweep of mesh sizes without opening a window, times their construction and the 
+// searches over them, and checks every faster path against a slower reference. Each --mode has a file of its own; build benchmark/*.cpp 
+// together with source/NavMesh.cpp, source/AStar.cpp, source/HPAStar.cpp, source/ContractionHierarchy.cpp, source/PathCache.cpp, 
+// source/MeshRenderer.cpp, source/MeshSnapshot.cpp, source/FreeSpaceSampler.cpp and source/Metrics.cpp, linking sfml-graphics 
+//
+// usage: Benchmark [--mode mesh|kernel|order|ch|render] [--sizes 100,1000,10000] [--obstacles 35] [--obstacle-scale 1] [--spacing 0] [--seed 1] [--queries 100] [--repeats 1] 
+//                  [--threads 0] [--landmarks 16] [--cache 1024] [--drags 100] [--frames 120] [--segments 100000] [--width 1344] [--height 756] 
+//                  [--format csv|json] [--out benchmark.csv] 
+// exits with 1 on bad arguments or an unwritable --out, and with 2 after writing the results if any of their mismatch, invalid path 
+// or sample violation counters is not 0, so that a CI run can gate on it 
+
+#include "Benchmark.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+	std::vector<int> ParseSizes(const std::string& arg) {
+		std::vector<int> res;
+		std::stringstream ss(arg);
+		std::string item;
+		while (std::getline(ss, item, ',')) if (!item.empty()) res.push_back(std::stoi(item));
+		return res;
+	}
+
+	bool ParseArgs(int argc, char** argv, Scenario& sc) {
+		for (int i = 1; i < argc; ++i) {
+
+			std::string arg = argv[i];
+			if (i + 1 >= argc) {
+				std::cerr << "Missing value for " << arg << "\n";
+				return false;
+			}
+			std::string val = argv[++i];
+
+			try {
+				if (arg == "--mode") sc.mode = val;
+				else if (arg == "--sizes") sc.sizes = ParseSizes(val);
+				else if (arg == "--obstacles") sc.obstacles = std::stoi(val);
+				else if (arg == "--obstacle-scale") sc.obstacle_scale = std::stof(val);
+				else if (arg == "--spacing") sc.spacing = std::stof(val);
+				else if (arg == "--seed") sc.seed = (unsigned int)std::stoul(val);
+				else if (arg == "--queries") sc.queries = std::stoi(val);
+				else if (arg == "--repeats") sc.repeats = std::stoi(val);
+				else if (arg == "--threads") sc.threads = std::stoi(val);
+				else if (arg == "--landmarks") sc.landmarks = std::stoi(val);
+				else if (arg == "--cache") sc.cache = std::stoi(val);
+				else if (arg == "--drags") sc.drags = std::stoi(val);
+				else if (arg == "--frames") sc.frames = std::stoi(val);
+				else if (arg == "--segments") sc.segments = std::stoi(val);
+				else if (arg == "--width") sc.width = std::stoi(val);
+				else if (arg == "--height") sc.height = std::stoi(val);
+				else if (arg == "--format") sc.format = val;
+				else if (arg == "--out") sc.out = val;
+				else {
+					std::cerr << "Unknown argument " << arg << "\n";
+					return false;
+				}
+			}
+			catch (const std::exception&) {
+				std::cerr << "Invalid value for " << arg << ": " << val << "\n";
+				return false;
+			}
+		}
+
+		for (int size : sc.sizes) if (size <= 2) {
+			std::cerr << "Mesh sizes must be at least 3\n";
+			return false;
+		}
+		if (sc.sizes.empty() || sc.obstacles < 0 || sc.obstacle_scale <= 0.0f || sc.spacing < 0.0f || sc.queries < 0 || sc.repeats <= 0 || sc.threads < 0 || sc.landmarks < 0 || sc.cache < 0 || sc.drags < 0 || sc.frames < 0 || sc.segments < 0 || sc.width <= 0 || sc.height <= 0) {
+			std::cerr << "Invalid scenario\n";
+			return false;
+		}
+		if (sc.mode != "mesh" && sc.mode != "kernel" && sc.mode != "order" && sc.mode != "ch" && sc.mode != "render") {
+			std::cerr << "Mode must be mesh, kernel, order, ch or render\n";
+			return false;
+		}
+		if (sc.format != "csv" && sc.format != "json") {
+			std::cerr << "Format must be csv or json\n";
+			return false;
+		}
+		return true;
+	}
+}
+
+Obstacles GenObstacles(int sc_w, int sc_h, int count, float scale, std::mt19937& gen) {
+
+	std::uniform_real_distribution<float> swidth(0.0f, (float)sc_w);
+	std::uniform_real_distribution<float> sheight(0.0f, (float)sc_h);
+	std::uniform_real_distribution<float> owidth(sc_w * 0.05f * scale, sc_w * 0.1f * scale);
+	std::uniform_real_distribution<float> oheight(sc_w * 0.05f * scale, sc_w * 0.1f * scale);
+
+	Obstacles res;
+	for (int i = 0; i < count; ++i) {
+		sf::Vector2f pos = sf::Vector2f(swidth(gen), sheight(gen));
+		res.push_back(std::make_pair(pos, sf::Vector2f(owidth(gen), oheight(gen))));
+	}
+	return res;
+}
+
+std::vector<std::pair<int, int>> EdgeSet(const NavMesh& mesh) {
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	std::vector<std::pair<int, int>> res;
+	for (int i = 0; i < graph.NodeCount(); ++i) {
+		for (int k = graph.Begin(i); k < graph.End(i); ++k) if (graph.neighbours[k] > i) res.push_back({ i, graph.neighbours[k] });
+	}
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+bool IsMeshPath(const NavMesh::Graph& graph, const std::vector<int>& path, int start, int destination) {
+	if (path.empty()) return true;
+	if (path.front() != start || path.back() != destination) return false;
+	for (size_t i = 1; i < path.size(); ++i) {
+		bool linked = false;
+		for (int k = graph.Begin(path[i - 1]); k < graph.End(path[i - 1]); ++k) if (graph.neighbours[k] == path[i]) linked = true;
+		if (!linked) return false;
+	}
+	return true;
+}
+
+std::vector<A_Star::Query> GenQueries(int count, int size, std::mt19937& gen) {
+	std::vector<A_Star::Query> queries;
+	std::uniform_int_distribution<int> pick(0, size - 1);
+	for (int q = 0; q < count; ++q) {
+		int s = pick(gen);
+		int e = pick(gen);
+		while (e == s) e = pick(gen);
+		queries.push_back({ s, e });
+	}
+	return queries;
+}
+
+
+int main(int argc, char** argv) {
+
+	Scenario sc;
+	if (!ParseArgs(argc, argv, sc)) return 1;
+
+	std::ofstream out(sc.out);
+	if (!out) {
+		std::cerr << "Could not open " << sc.out << "\n";
+		return 1;
+	}
+
+	// NavMesh and A* report their outcomes as metrics events, which reach no console here: the modes install no Metrics::Console 
+	long long failures = 0;
+	if (sc.mode == "kernel") failures = RunKernelMode(sc, out);
+	else if (sc.mode == "order") failures = RunOrderMode(sc, out);
+	else if (sc.mode == "ch") failures = RunChMode(sc, out);
+	else if (sc.mode == "render") failures = RunRenderMode(sc, out);
+	else failures = RunMeshMode(sc, out);
+
+	std::cerr << "Results written to " << sc.out << "\n";
+	if (failures > 0) {
+		std::cerr << failures << " checks failed, see the mismatch, invalid path and sample violation columns\n";
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "AStar.h"
+#include "NavMesh.h"
+
+#include <string>
+
+
+typedef std::vector<std::pair<sf::Vector2f, sf::Vector2f>> Obstacles;
+
+// What the command line asks for, shared by all the modes 
+struct Scenario {
+	std::string mode = "mesh";
+	std::vector<int> sizes = { 100, 1000, 10000 };
+	int obstacles = 35;
+	float obstacle_scale = 1.0f; // grows or shrinks the obstacles 
+	float spacing = 0.0f; // no two nodes closer than this, sampled as blue noise, which may place fewer nodes than the size asks for 
+	unsigned int seed = 1;
+	int queries = 100;
+	int repeats = 1;
+	int threads = 0; // 0 for the hardware concurrency 
+	int landmarks = 16;
+	int cache = 1024;
+	int drags = 100;
+	int frames = 120;
+	int segments = 100000;
+	int width = 1344; // 70% of a 1920x1080 desktop, as in main.cpp 
+	int height = 756;
+	std::string format = "csv";
+	std::string out = "benchmark.csv";
+};
+
+// same distribution as Interface::GetObstacleDisplay(), with a fixed obstacle count and seed, and the sizes scaled 
+Obstacles GenObstacles(int sc_w, int sc_h, int count, float scale, std::mt19937& gen);
+
+// the mesh edges as sorted (lower id, higher id) pairs 
+std::vector<std::pair<int, int>> EdgeSet(const NavMesh& mesh);
+
+// whether the path runs along mesh edges from start to destination (an empty path, for no path found, passes) 
+bool IsMeshPath(const NavMesh::Graph& graph, const std::vector<int>& path, int start, int destination);
+
+// random start / destination pairs, never the same node twice 
+std::vector<A_Star::Query> GenQueries(int count, int size, std::mt19937& gen);
+
+// the modes, one per file: each runs the scenario, writes its rows to out as sc.format says and returns how many of their checks failed 
+long long RunMeshMode(const Scenario& sc, std::ostream& out);
+long long RunKernelMode(const Scenario& sc, std::ostream& out);
+long long RunOrderMode(const Scenario& sc, std::ostream& out);
+long long RunChMode(const Scenario& sc, std::ostream& out);
+long long RunRenderMode(const Scenario& sc, std::ostream& out);
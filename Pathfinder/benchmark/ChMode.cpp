@@ -0,0 +1,109 @@
+// --mode ch: builds a ContractionHierarchy over each mesh and answers the queries with it and with plain A*; the hierarchy's paths must be 
+// mesh paths as short as A*'s 
+
+#include "Benchmark.h"
+#include "ContractionHierarchy.h"
+
+namespace {
+
+	// one row of --mode ch 
+	struct ChResult {
+		int size = 0;
+		unsigned int seed = 0;
+		int repeat = 0;
+		int edges = 0;
+		int shortcuts = 0;
+		long long ch_build_us = 0;
+		size_t ch_memory = 0;
+		int queries = 0;
+		long long search_us = 0; // plain A* 
+		long long ch_search_us = 0;
+		long long expanded = 0;
+		long long ch_expanded = 0;
+		int cost_mismatches = 0;
+		int invalid_paths = 0; // not mesh paths, or found where A* found none or the other way round 
+	};
+
+	ChResult RunCh(const Scenario& sc, int size, int repeat) {
+
+		ChResult res;
+		res.size = size;
+		res.seed = sc.seed + repeat;
+		res.repeat = repeat;
+		res.queries = sc.queries;
+
+		std::mt19937 gen(res.seed);
+		Obstacles obstacles = GenObstacles(sc.width, sc.height, sc.obstacles, sc.obstacle_scale, gen);
+		NavMesh mesh(sc.width, sc.height, size, obstacles, gen(), sc.threads);
+		const NavMesh::Graph& graph = mesh.GetGraph();
+		res.edges = graph.EdgeCount();
+
+		ContractionHierarchy hierarchy;
+		auto start = std::chrono::high_resolution_clock::now();
+		hierarchy.Build(mesh);
+		res.ch_build_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		res.shortcuts = hierarchy.GetShortcutCount();
+		res.ch_memory = hierarchy.GetMemoryUsage();
+
+		A_Star::SearchContext context;
+		ContractionHierarchy::SearchContext ch_context;
+		for (const A_Star::Query& query : GenQueries(sc.queries, size, gen)) {
+
+			start = std::chrono::high_resolution_clock::now();
+			std::vector<int> path = A_Star::Find(mesh, query.start, query.destination, context);
+			res.search_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			res.expanded += context.GetStats().expanded;
+
+			start = std::chrono::high_resolution_clock::now();
+			std::vector<int> ch_path = hierarchy.Find(query.start, query.destination, ch_context);
+			res.ch_search_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			res.ch_expanded += ch_context.GetStats().expanded;
+
+			// both are shortest, but equal-length paths may sum their edges in another order 
+			float cost = context.GetStats().cost;
+			if (std::fabs(ch_context.GetStats().cost - cost) > 1e-4f * std::max(1.0f, cost)) ++res.cost_mismatches;
+			if (path.empty() != ch_path.empty() || !IsMeshPath(graph, ch_path, query.start, query.destination)) ++res.invalid_paths;
+		}
+		return res;
+	}
+
+	void WriteChCSV(std::ostream& out, const std::vector<ChResult>& results) {
+		out << "size,seed,repeat,edges,shortcuts,ch_build_us,ch_memory,queries,search_us,ch_search_us,expanded,ch_expanded,cost_mismatches,invalid_paths\n";
+		for (const ChResult& r : results) {
+			out << r.size << ',' << r.seed << ',' << r.repeat << ',' << r.edges << ',' << r.shortcuts << ',' << r.ch_build_us << ',' << r.ch_memory << ','
+				<< r.queries << ',' << r.search_us << ',' << r.ch_search_us << ',' << r.expanded << ',' << r.ch_expanded << ','
+				<< r.cost_mismatches << ',' << r.invalid_paths << '\n';
+		}
+	}
+
+	void WriteChJSON(std::ostream& out, const std::vector<ChResult>& results) {
+		out << "[\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const ChResult& r = results[i];
+			out << "  {\"size\": " << r.size << ", \"seed\": " << r.seed << ", \"repeat\": " << r.repeat << ", \"edges\": " << r.edges
+				<< ", \"shortcuts\": " << r.shortcuts << ", \"ch_build_us\": " << r.ch_build_us << ", \"ch_memory\": " << r.ch_memory
+				<< ", \"queries\": " << r.queries << ", \"search_us\": " << r.search_us << ", \"ch_search_us\": " << r.ch_search_us
+				<< ", \"expanded\": " << r.expanded << ", \"ch_expanded\": " << r.ch_expanded
+				<< ", \"cost_mismatches\": " << r.cost_mismatches << ", \"invalid_paths\": " << r.invalid_paths << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+}
+
+long long RunChMode(const Scenario& sc, std::ostream& out) {
+
+	std::vector<ChResult> results;
+	for (int size : sc.sizes) {
+		for (int r = 0; r < sc.repeats; ++r) {
+			std::cerr << "mesh size " << size << ", repeat " << r + 1 << "/" << sc.repeats << "\n";
+			results.push_back(RunCh(sc, size, r));
+		}
+	}
+	if (sc.format == "json") WriteChJSON(out, results);
+	else WriteChCSV(out, results);
+
+	long long failures = 0;
+	for (const ChResult& r : results) failures += (long long)r.cost_mismatches + r.invalid_paths;
+	return failures;
+}
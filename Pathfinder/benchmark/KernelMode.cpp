@@ -0,0 +1,150 @@
+// --mode kernel: times the segment vs rectangle kernel of SegmentRect.h on every path compiled in (scalar, SSE, AVX2) over --segments random 
+// mesh-edge-sized segments against --obstacles rectangles, and checks each path against the scalar one and a double precision clip 
+
+#include "Benchmark.h"
+#include "SegmentRect.h"
+
+namespace {
+
+	// one row of --mode kernel 
+	struct KernelResult {
+		std::string path;
+		int rects = 0;
+		unsigned int seed = 0;
+		int segments = 0;
+		long long kernel_us = 0;
+		int hits = 0; // segments that hit at least one rectangle 
+		int scalar_mismatches = 0;
+		int reference_mismatches = 0;
+	};
+
+	// closed-box Liang-Barsky clip of the segment, in double 
+	bool ReferenceHit(float x0, float y0, float x1, float y1, const std::pair<sf::Vector2f, sf::Vector2f>& rect) {
+
+		double start[2] = { x0, y0 };
+		double dir[2] = { (double)x1 - x0, (double)y1 - y0 };
+		double lo[2] = { rect.first.x, rect.first.y };
+		double hi[2] = { rect.first.x + rect.second.x, rect.first.y + rect.second.y };
+
+		double t0 = 0.0, t1 = 1.0;
+		for (int axis = 0; axis < 2; ++axis) {
+			if (dir[axis] == 0.0) {
+				if (start[axis] < lo[axis] || start[axis] > hi[axis]) return false;
+				continue;
+			}
+			double a = (lo[axis] - start[axis]) / dir[axis];
+			double b = (hi[axis] - start[axis]) / dir[axis];
+			if (a > b) std::swap(a, b);
+			t0 = std::max(t0, a);
+			t1 = std::min(t1, b);
+			if (t0 > t1) return false;
+		}
+		return true;
+	}
+
+	typedef int (*KernelPath)(struct SegmentTerms, const float*, const float*, const float*, const float*, int, int);
+
+	std::vector<KernelResult> RunKernel(const Scenario& sc, int repeat) {
+
+		std::mt19937 gen(sc.seed + repeat);
+		Obstacles rects = GenObstacles(sc.width, sc.height, sc.obstacles, sc.obstacle_scale, gen);
+
+		// centres and half extents, computed as the obstacle grid does 
+		std::vector<float> cx, cy, hx, hy;
+		for (const auto& rect : rects) {
+			float min_x = rect.first.x, max_x = rect.first.x + rect.second.x;
+			float min_y = rect.first.y, max_y = rect.first.y + rect.second.y;
+			cx.push_back((min_x + max_x) * 0.5f);
+			cy.push_back((min_y + max_y) * 0.5f);
+			hx.push_back((max_x - min_x) * 0.5f);
+			hy.push_back((max_y - min_y) * 0.5f);
+		}
+
+		// segments up to about the length of a mesh edge 
+		std::uniform_real_distribution<float> swidth(0.0f, (float)sc.width);
+		std::uniform_real_distribution<float> sheight(0.0f, (float)sc.height);
+		std::uniform_real_distribution<float> offset(-60.0f, 60.0f);
+		std::vector<float> segments;
+		for (int i = 0; i < sc.segments; ++i) {
+			float x = swidth(gen), y = sheight(gen);
+			segments.insert(segments.end(), { x, y, x + offset(gen), y + offset(gen) });
+		}
+
+		std::vector<char> reference(sc.segments, 0);
+		for (int i = 0; i < sc.segments; ++i) {
+			const float* seg = &segments[4 * i];
+			for (const auto& rect : rects) if (ReferenceHit(seg[0], seg[1], seg[2], seg[3], rect)) reference[i] = 1;
+		}
+
+		std::vector<std::pair<std::string, KernelPath>> paths = { { "scalar", SegmentHitsRectsScalar } };
+#ifdef SEGMENT_RECT_SSE
+		paths.push_back({ "sse", SegmentHitsRectsSSE });
+#endif
+#ifdef SEGMENT_RECT_AVX2
+		paths.push_back({ "avx2", SegmentHitsRectsAVX2 });
+#endif
+
+		std::vector<KernelResult> res;
+		std::vector<char> scalar(sc.segments, 0), hits(sc.segments, 0);
+		int count = (int)rects.size();
+		for (const auto& path : paths) {
+
+			KernelResult row;
+			row.path = path.first;
+			row.rects = count;
+			row.seed = sc.seed + repeat;
+			row.segments = sc.segments;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < sc.segments; ++i) {
+				const float* seg = &segments[4 * i];
+				hits[i] = (char)path.second(GetSegmentTerms(seg[0], seg[1], seg[2], seg[3]), cx.data(), cy.data(), hx.data(), hy.data(), 0, count);
+			}
+			row.kernel_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+			if (path.first == "scalar") scalar = hits;
+			for (int i = 0; i < sc.segments; ++i) {
+				row.hits += hits[i];
+				if (hits[i] != scalar[i]) ++row.scalar_mismatches;
+				if (hits[i] != reference[i]) ++row.reference_mismatches;
+			}
+			res.push_back(row);
+		}
+		return res;
+	}
+
+	void WriteKernelCSV(std::ostream& out, const std::vector<KernelResult>& results) {
+		out << "path,rects,seed,segments,kernel_us,hits,scalar_mismatches,reference_mismatches\n";
+		for (const KernelResult& r : results) {
+			out << r.path << ',' << r.rects << ',' << r.seed << ',' << r.segments << ',' << r.kernel_us << ',' << r.hits << ','
+				<< r.scalar_mismatches << ',' << r.reference_mismatches << '\n';
+		}
+	}
+
+	void WriteKernelJSON(std::ostream& out, const std::vector<KernelResult>& results) {
+		out << "[\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const KernelResult& r = results[i];
+			out << "  {\"path\": \"" << r.path << "\", \"rects\": " << r.rects << ", \"seed\": " << r.seed << ", \"segments\": " << r.segments
+				<< ", \"kernel_us\": " << r.kernel_us << ", \"hits\": " << r.hits
+				<< ", \"scalar_mismatches\": " << r.scalar_mismatches << ", \"reference_mismatches\": " << r.reference_mismatches << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+}
+
+long long RunKernelMode(const Scenario& sc, std::ostream& out) {
+
+	std::vector<KernelResult> results;
+	for (int r = 0; r < sc.repeats; ++r) {
+		std::vector<KernelResult> rows = RunKernel(sc, r);
+		results.insert(results.end(), rows.begin(), rows.end());
+	}
+	if (sc.format == "json") WriteKernelJSON(out, results);
+	else WriteKernelCSV(out, results);
+
+	long long failures = 0;
+	for (const KernelResult& r : results) failures += (long long)r.scalar_mismatches + r.reference_mismatches;
+	return failures;
+}
@@ -0,0 +1,441 @@
+// --mode mesh, the default: builds a NavMesh per size and repeat and times its construction, then answers the queries through every search 
+// there is (one at a time, batched, bidirectional, with landmarks, through HPA_Star and through a PathCache) and snaps points to the node 
+// grid, checking each against plain A* or a scan. The mesh is also saved as a MeshSnapshot next to --out and loaded back, and --drags nodes 
+// are moved as in the Interface 
+
+#include "Benchmark.h"
+#include "HPAStar.h"
+#include "MeshSnapshot.h"
+#include "Metrics.h"
+#include "PathCache.h"
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+	// one row of --mode mesh 
+	struct Result {
+		int size = 0;
+		int obstacles = 0;
+		unsigned int seed = 0;
+		int repeat = 0;
+		int nodes = 0;
+		int edges = 0;
+		long long sampling_us = 0;
+		int sampling_rejections = 0; // points drawn again 
+		int sample_violations = 0; // nodes within NavMesh::OBSTACLE_CLEARANCE of an obstacle, or closer than --spacing to another 
+		long long triangulation_us = 0;
+		long long filtering_us = 0;
+		int strips = 1; // 1 when the mesh was triangulated serially 
+		long long merge_us = 0; // the serial merge of the strips 
+		long long serial_triangulation_us = 0; // 0 unless the mesh was triangulated in parallel 
+		int parallel_mismatches = 0; // edges only one of the parallel build and its serial repeat has 
+		size_t scratch_peak = 0; // bytes 
+		long long search_us = 0;
+		long long batch_us = 0;
+		int threads = 0;
+		int batch_mismatches = 0; // batch queries whose path cost differs from the sequential run 
+		long long bidi_search_us = 0;
+		long long bidi_expanded_forward = 0;
+		long long bidi_expanded_backward = 0;
+		int bidi_mismatches = 0; // bidirectional queries whose path cost differs from the forward search's, or whose path is not a mesh path 
+		long long metrics_search_us = 0; // search_us again, with a Metrics::Totals sink installed 
+		int metrics_mismatches = 0; // Metrics::Totals counters that differ from the search stats 
+		size_t snapshot_bytes = 0;
+		long long snapshot_save_us = 0;
+		long long snapshot_load_us = 0;
+		long long snapshot_verify_us = 0;
+		int snapshot_mismatches = 0; // graph entries and path costs the loaded mesh gets wrong, and corrupted copies that pass Verify() 
+		int landmarks = 0;
+		long long landmarks_us = 0;
+		size_t landmark_memory = 0; // bytes 
+		long long alt_search_us = 0;
+		long long alt_expanded = 0;
+		int alt_mismatches = 0; // queries whose path cost differs from the straight-line heuristic's 
+		long long hpa_build_us = 0;
+		size_t hpa_memory = 0; // bytes 
+		long long hpa_search_us = 0;
+		long long hpa_expanded = 0; // abstract search expansions summed over all queries 
+		double hpa_path_cost = 0.0;
+		int hpa_mismatches = 0; // paths that are not mesh paths, or found where A* found none or the other way round 
+		int drags = 0;
+		long long drag_us = 0;
+		int drag_rebuilds = 0; // moves that fell back to rebuilding the whole mesh 
+		long long hpa_update_us = 0;
+		int hpa_updated_clusters = 0;
+		long long cache_first_us = 0; // the pass that fills the cache; cache_repeat_us is answered from it 
+		long long cache_repeat_us = 0;
+		long long cache_hits = 0;
+		long long cache_misses = 0;
+		long long cache_evictions = 0;
+		long long cache_invalidated = 0;
+		int cache_invalid_paths = 0; // cached paths the drags left that are not mesh paths any more 
+		long long snap_us = 0;
+		long long snap_scan_us = 0; // the same points snapped by a scan over every node 
+		int snap_mismatches = 0; // points whose nearest node, 8 nearest nodes or nodes within 20 pixels differ from the scan's 
+		int queries = 0;
+		int paths_found = 0;
+		long long expanded = 0; // A* expansions summed over all queries 
+		double path_cost = 0.0; // lengths of the found paths, summed 
+	};
+
+	Result Run(const Scenario& sc, int size, int repeat) {
+
+		Result res;
+		res.size = size;
+		res.obstacles = sc.obstacles;
+		res.seed = sc.seed + repeat;
+		res.repeat = repeat;
+		res.queries = sc.queries;
+
+		std::mt19937 gen(res.seed);
+		Obstacles obstacles = GenObstacles(sc.width, sc.height, sc.obstacles, sc.obstacle_scale, gen);
+
+		NavMesh mesh(sc.width, sc.height, size, obstacles, gen(), sc.threads, sc.spacing);
+		res.nodes = mesh.GetGraph().NodeCount();
+		res.sampling_us = mesh.GetBuildTimings().sampling_us;
+		res.sampling_rejections = mesh.GetBuildTimings().sampling_rejections;
+		res.triangulation_us = mesh.GetBuildTimings().triangulation_us;
+		res.filtering_us = mesh.GetBuildTimings().filtering_us;
+		res.strips = mesh.GetBuildTimings().triangulation_strips;
+		res.merge_us = mesh.GetBuildTimings().merge_us;
+		res.edges = mesh.GetGraph().EdgeCount();
+		res.scratch_peak = mesh.GetScratchPeak();
+
+		// every node must keep clear of the obstacles, and of the other nodes by the spacing 
+		const NavMesh::Graph& nodes = mesh.GetGraph();
+		for (int i = 0; i < res.nodes; ++i) {
+			sf::Vector2f pt = nodes.Position(i);
+			for (const std::pair<sf::Vector2f, sf::Vector2f>& obs : obstacles) {
+				sf::Vector2f far_corner = obs.first + obs.second;
+				float c = NavMesh::OBSTACLE_CLEARANCE;
+				if (pt.x >= std::min(obs.first.x, far_corner.x) - c && pt.x <= std::max(obs.first.x, far_corner.x) + c
+					&& pt.y >= std::min(obs.first.y, far_corner.y) - c && pt.y <= std::max(obs.first.y, far_corner.y) + c) {
+					++res.sample_violations;
+					break;
+				}
+			}
+			if (sc.spacing <= 0.0f) continue;
+			for (int j : mesh.FindWithin(pt, sc.spacing)) {
+				sf::Vector2f d = nodes.Position(j) - pt;
+				if (j > i && d.x * d.x + d.y * d.y < sc.spacing * sc.spacing) ++res.sample_violations;
+			}
+		}
+		if (res.nodes < 3) return res;
+
+		// a parallel build must give the serial build's edges 
+		if (res.strips > 1) {
+			std::vector<std::pair<int, int>> parallel = EdgeSet(mesh);
+			mesh.SetBuildThreads(1);
+			mesh.Remake(sc.width, sc.height, res.nodes, obstacles);
+			res.serial_triangulation_us = mesh.GetBuildTimings().triangulation_us;
+			std::vector<std::pair<int, int>> serial = EdgeSet(mesh);
+
+			std::vector<std::pair<int, int>> diff;
+			std::set_symmetric_difference(parallel.begin(), parallel.end(), serial.begin(), serial.end(), std::back_inserter(diff));
+			res.parallel_mismatches = (int)diff.size();
+			mesh.SetBuildThreads(sc.threads);
+		}
+
+		A_Star::SearchContext context;
+		std::vector<A_Star::Query> queries = GenQueries(sc.queries, res.nodes, gen);
+
+		std::vector<float> costs;
+		for (const A_Star::Query& query : queries) {
+
+			auto start = std::chrono::high_resolution_clock::now();
+			std::vector<int> path = A_Star::Find(mesh, query.start, query.destination, context);
+			res.search_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+			if (!path.empty()) ++res.paths_found;
+			res.expanded += context.GetStats().expanded;
+			res.path_cost += context.GetStats().cost;
+			costs.push_back(context.GetStats().cost);
+		}
+
+		// the metrics must add up to the search stats 
+#ifndef PATHFINDER_NO_METRICS
+		{
+			Metrics::Totals totals;
+			Metrics::AddSink(&totals);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (const A_Star::Query& query : queries) A_Star::Find(mesh, query.start, query.destination, context);
+			res.metrics_search_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			Metrics::RemoveSink(&totals);
+
+			if (totals.GetHistogram(Metrics::SEARCH_US).count != (long long)queries.size()) ++res.metrics_mismatches;
+			if (totals.GetCount(Metrics::PATHS_FOUND) != res.paths_found) ++res.metrics_mismatches;
+			if (totals.GetCount(Metrics::PATHS_FOUND) + totals.GetCount(Metrics::PATHS_NOT_FOUND) != (long long)queries.size()) ++res.metrics_mismatches;
+			if (totals.GetCount(Metrics::NODES_EXPANDED) != res.expanded) ++res.metrics_mismatches;
+		}
+#endif
+
+		res.threads = sc.threads > 0 ? sc.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<A_Star::Result> batch = A_Star::FindBatch(mesh, queries, res.threads);
+		res.batch_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// the batch must agree with the sequential run 
+		for (size_t q = 0; q < batch.size(); ++q) if (batch[q].stats.cost != costs[q]) ++res.batch_mismatches;
+
+		// the bidirectional search must find paths as short as the forward search's 
+		const NavMesh::Graph& graph = mesh.GetGraph();
+		context.SetMode(A_Star::BIDIRECTIONAL);
+		for (size_t q = 0; q < queries.size(); ++q) {
+
+			start = std::chrono::high_resolution_clock::now();
+			std::vector<int> path = A_Star::Find(mesh, queries[q].start, queries[q].destination, context);
+			res.bidi_search_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			res.bidi_expanded_forward += context.GetStats().expanded_forward;
+			res.bidi_expanded_backward += context.GetStats().expanded_backward;
+
+			bool valid = path.empty() == batch[q].path.empty() && IsMeshPath(graph, path, queries[q].start, queries[q].destination);
+			if (!valid || std::fabs(context.GetStats().cost - costs[q]) > 1e-4f * std::max(1.0f, costs[q])) ++res.bidi_mismatches;
+		}
+		context.SetMode(A_Star::FORWARD);
+
+		// the snapshot must give back the same graph, and the same answers 
+		std::string snapshot_path = sc.out + ".navmesh";
+		start = std::chrono::high_resolution_clock::now();
+		mesh.Save(snapshot_path);
+		res.snapshot_save_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		{
+			MeshSnapshot snapshot;
+			start = std::chrono::high_resolution_clock::now();
+			snapshot.Open(snapshot_path);
+			NavMesh loaded(snapshot, sc.threads);
+			res.snapshot_load_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			res.snapshot_bytes = snapshot.GetSize();
+
+			start = std::chrono::high_resolution_clock::now();
+			if (!snapshot.Verify()) ++res.snapshot_mismatches;
+			res.snapshot_verify_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+			const NavMesh::Graph& copy = loaded.GetGraph();
+			if (copy.NodeCount() != graph.NodeCount() || copy.neighbours.size() != graph.neighbours.size()) ++res.snapshot_mismatches;
+			else {
+				for (int i = 0; i < graph.NodeCount(); ++i) if (copy.xs[i] != graph.xs[i] || copy.ys[i] != graph.ys[i] || copy.offsets[i + 1] != graph.offsets[i + 1]) ++res.snapshot_mismatches;
+				for (size_t k = 0; k < graph.neighbours.size(); ++k) if (copy.neighbours[k] != graph.neighbours[k] || copy.weights[k] != graph.weights[k]) ++res.snapshot_mismatches;
+
+				A_Star::SearchContext loaded_context;
+				for (size_t q = 0; q < queries.size(); ++q) {
+					A_Star::Find(loaded, queries[q].start, queries[q].destination, loaded_context);
+					if (loaded_context.GetStats().cost != costs[q]) ++res.snapshot_mismatches;
+				}
+			}
+		}
+
+		// a flipped byte in the middle of the file, or in the header's mesh width, must fail the checksum 
+		std::streamoff flips[2] = { (std::streamoff)(res.snapshot_bytes / 2), (std::streamoff)offsetof(MeshSnapshot::Header, width) };
+		for (std::streamoff at : flips) {
+			mesh.Save(snapshot_path);
+			{
+				std::fstream file(snapshot_path, std::ios::in | std::ios::out | std::ios::binary);
+				file.seekg(at);
+				char byte = 0;
+				file.read(&byte, 1);
+				byte = (char)~byte;
+				file.seekp(at);
+				file.write(&byte, 1);
+			}
+			MeshSnapshot corrupt;
+			if (corrupt.Open(snapshot_path) && corrupt.Verify()) ++res.snapshot_mismatches;
+		}
+		std::remove(snapshot_path.c_str());
+
+		// ALT must find paths as short as the straight-line heuristic's, expanding fewer nodes 
+		if (sc.landmarks > 0) {
+			mesh.BuildLandmarks(sc.landmarks);
+			res.landmarks = mesh.GetLandmarks().count;
+			res.landmarks_us = mesh.GetBuildTimings().landmarks_us;
+			res.landmark_memory = mesh.GetLandmarks().GetMemoryUsage();
+
+			context.SetHeuristic(A_Star::Landmarks);
+			for (size_t q = 0; q < queries.size(); ++q) {
+
+				start = std::chrono::high_resolution_clock::now();
+				A_Star::Find(mesh, queries[q].start, queries[q].destination, context);
+				res.alt_search_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+				res.alt_expanded += context.GetStats().expanded;
+
+				// equal-length paths may sum their edges in another order 
+				if (std::fabs(context.GetStats().cost - costs[q]) > 1e-4f * std::max(1.0f, costs[q])) ++res.alt_mismatches;
+			}
+			context.SetHeuristic(A_Star::Euclidean);
+		}
+
+		HPA_Star hierarchy;
+		start = std::chrono::high_resolution_clock::now();
+		hierarchy.Build(mesh);
+		res.hpa_build_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		res.hpa_memory = hierarchy.GetMemoryUsage();
+
+		HPA_Star::SearchContext hpa_context;
+		for (size_t q = 0; q < queries.size(); ++q) {
+
+			start = std::chrono::high_resolution_clock::now();
+			std::vector<int> path = hierarchy.Find(mesh, queries[q].start, queries[q].destination, hpa_context);
+			res.hpa_search_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+			res.hpa_expanded += hpa_context.GetStats().expanded;
+			res.hpa_path_cost += hpa_context.GetStats().cost;
+
+			// the path must run along mesh edges from the start to the destination, and exist exactly when A* found one 
+			if (path.empty() != batch[q].path.empty() || !IsMeshPath(graph, path, queries[q].start, queries[q].destination)) ++res.hpa_mismatches;
+		}
+
+		// the first pass fills the cache, the second is answered from it as far as it holds the queries 
+		PathCache cache((size_t)sc.cache);
+		for (long long* pass_us : { &res.cache_first_us, &res.cache_repeat_us }) {
+			start = std::chrono::high_resolution_clock::now();
+			for (const A_Star::Query& query : queries) cache.Find(mesh, query.start, query.destination, context);
+			*pass_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		res.drags = sc.drags;
+		std::uniform_int_distribution<int> pick(0, res.nodes - 1);
+		std::uniform_real_distribution<float> nudge(-5.0f, 5.0f);
+		for (int d = 0; d < sc.drags; ++d) {
+			int id = pick(gen);
+			sf::Vector2f pos = mesh.GetGraph().Position(id) + sf::Vector2f(nudge(gen), nudge(gen));
+			if (!mesh.MoveNode(id, pos)) ++res.drag_rebuilds;
+			res.drag_us += mesh.GetBuildTimings().update_us;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		res.hpa_updated_clusters = hierarchy.Update(mesh);
+		res.hpa_update_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// the entries the drags left in the cache must still be paths of the moved mesh 
+		for (const A_Star::Query& query : queries) {
+			std::vector<int> path = cache.Find(mesh, query.start, query.destination, context);
+			if (!IsMeshPath(graph, path, query.start, query.destination)) ++res.cache_invalid_paths;
+		}
+		res.cache_hits = cache.GetStats().hits;
+		res.cache_misses = cache.GetStats().misses;
+		res.cache_evictions = cache.GetStats().evictions;
+		res.cache_invalidated = cache.GetStats().invalidations;
+
+		// the node grid must agree with a scan over every node; points off the mesh's edge are snapped too 
+		std::uniform_real_distribution<float> px(-50.0f, sc.width + 50.0f);
+		std::uniform_real_distribution<float> py(-50.0f, sc.height + 50.0f);
+		std::vector<sf::Vector2f> points(sc.queries * 10);
+		for (sf::Vector2f& point : points) point = sf::Vector2f(px(gen), py(gen));
+
+		auto dist2 = [&](int id, sf::Vector2f point) {
+			float dx = graph.xs[id] - point.x;
+			float dy = graph.ys[id] - point.y;
+			return dx * dx + dy * dy;
+		};
+
+		std::vector<int> nearest(points.size());
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t p = 0; p < points.size(); ++p) nearest[p] = mesh.FindNearest(points[p]);
+		res.snap_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		std::vector<int> scanned(points.size(), -1);
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t p = 0; p < points.size(); ++p) {
+			float best = std::numeric_limits<float>::infinity();
+			for (int id = 0; id < graph.NodeCount(); ++id) {
+				float d2 = dist2(id, points[p]);
+				if (d2 < best) {
+					best = d2;
+					scanned[p] = id;
+				}
+			}
+		}
+		res.snap_scan_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// ties may pick different nodes, so the distances are compared 
+		for (size_t p = 0; p < points.size(); ++p) {
+
+			bool valid = nearest[p] != -1 && dist2(nearest[p], points[p]) == dist2(scanned[p], points[p]);
+
+			std::vector<int> k_nearest = mesh.FindKNearest(points[p], 8);
+			std::vector<float> k_scan;
+			for (int id = 0; id < graph.NodeCount(); ++id) k_scan.push_back(dist2(id, points[p]));
+			size_t k = std::min<size_t>(8, k_scan.size());
+			std::partial_sort(k_scan.begin(), k_scan.begin() + k, k_scan.end());
+			valid = valid && k_nearest.size() == k;
+			for (size_t i = 0; valid && i < k_nearest.size(); ++i) valid = dist2(k_nearest[i], points[p]) == k_scan[i];
+
+			std::vector<int> within = mesh.FindWithin(points[p], 20.0f);
+			std::vector<int> within_scan;
+			for (int id = 0; id < graph.NodeCount(); ++id) if (dist2(id, points[p]) <= 400.0f) within_scan.push_back(id);
+			std::sort(within.begin(), within.end());
+			valid = valid && within == within_scan;
+
+			if (!valid) ++res.snap_mismatches;
+		}
+
+		return res;
+	}
+
+	void WriteCSV(std::ostream& out, const std::vector<Result>& results) {
+		out << "size,obstacles,seed,repeat,nodes,edges,sampling_us,sampling_rejections,sample_violations,triangulation_us,filtering_us,strips,merge_us,serial_triangulation_us,parallel_mismatches,scratch_peak,search_us,batch_us,threads,batch_mismatches,bidi_search_us,bidi_expanded_forward,bidi_expanded_backward,bidi_mismatches,metrics_search_us,metrics_mismatches,snapshot_bytes,snapshot_save_us,snapshot_load_us,snapshot_verify_us,snapshot_mismatches,landmarks,landmarks_us,landmark_memory,alt_search_us,alt_expanded,alt_mismatches,hpa_build_us,hpa_memory,hpa_search_us,hpa_expanded,hpa_path_cost,hpa_mismatches,drags,drag_us,drag_rebuilds,hpa_update_us,hpa_updated_clusters,cache_first_us,cache_repeat_us,cache_hits,cache_misses,cache_evictions,cache_invalidated,cache_invalid_paths,snap_us,snap_scan_us,snap_mismatches,queries,paths_found,expanded,path_cost\n";
+		for (const Result& r : results) {
+			out << r.size << ',' << r.obstacles << ',' << r.seed << ',' << r.repeat << ',' << r.nodes << ',' << r.edges << ','
+				<< r.sampling_us << ',' << r.sampling_rejections << ',' << r.sample_violations << ',' << r.triangulation_us << ',' << r.filtering_us << ',' << r.strips << ',' << r.merge_us << ',' << r.serial_triangulation_us << ',' << r.parallel_mismatches << ',' << r.scratch_peak << ',' << r.search_us << ',' << r.batch_us << ',' << r.threads << ',' << r.batch_mismatches << ','
+				<< r.bidi_search_us << ',' << r.bidi_expanded_forward << ',' << r.bidi_expanded_backward << ',' << r.bidi_mismatches << ',' << r.metrics_search_us << ',' << r.metrics_mismatches << ','
+				<< r.snapshot_bytes << ',' << r.snapshot_save_us << ',' << r.snapshot_load_us << ',' << r.snapshot_verify_us << ',' << r.snapshot_mismatches << ','
+				<< r.landmarks << ',' << r.landmarks_us << ',' << r.landmark_memory << ',' << r.alt_search_us << ',' << r.alt_expanded << ',' << r.alt_mismatches << ','
+				<< r.hpa_build_us << ',' << r.hpa_memory << ',' << r.hpa_search_us << ',' << r.hpa_expanded << ',' << r.hpa_path_cost << ',' << r.hpa_mismatches << ','
+				<< r.drags << ',' << r.drag_us << ',' << r.drag_rebuilds << ',' << r.hpa_update_us << ',' << r.hpa_updated_clusters << ','
+				<< r.cache_first_us << ',' << r.cache_repeat_us << ',' << r.cache_hits << ',' << r.cache_misses << ',' << r.cache_evictions << ','
+				<< r.cache_invalidated << ',' << r.cache_invalid_paths << ',' << r.snap_us << ',' << r.snap_scan_us << ',' << r.snap_mismatches << ','
+				<< r.queries << ',' << r.paths_found << ',' << r.expanded << ',' << r.path_cost << '\n';
+		}
+	}
+
+	void WriteJSON(std::ostream& out, const std::vector<Result>& results) {
+		out << "[\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			out << "  {\"size\": " << r.size << ", \"obstacles\": " << r.obstacles << ", \"seed\": " << r.seed
+				<< ", \"repeat\": " << r.repeat << ", \"nodes\": " << r.nodes << ", \"edges\": " << r.edges
+				<< ", \"sampling_us\": " << r.sampling_us << ", \"sampling_rejections\": " << r.sampling_rejections << ", \"sample_violations\": " << r.sample_violations << ", \"triangulation_us\": " << r.triangulation_us
+				<< ", \"filtering_us\": " << r.filtering_us << ", \"strips\": " << r.strips << ", \"merge_us\": " << r.merge_us << ", \"serial_triangulation_us\": " << r.serial_triangulation_us
+				<< ", \"parallel_mismatches\": " << r.parallel_mismatches << ", \"scratch_peak\": " << r.scratch_peak << ", \"search_us\": " << r.search_us
+				<< ", \"batch_us\": " << r.batch_us << ", \"threads\": " << r.threads << ", \"batch_mismatches\": " << r.batch_mismatches
+				<< ", \"bidi_search_us\": " << r.bidi_search_us << ", \"bidi_expanded_forward\": " << r.bidi_expanded_forward
+				<< ", \"bidi_expanded_backward\": " << r.bidi_expanded_backward << ", \"bidi_mismatches\": " << r.bidi_mismatches
+				<< ", \"metrics_search_us\": " << r.metrics_search_us << ", \"metrics_mismatches\": " << r.metrics_mismatches
+				<< ", \"snapshot_bytes\": " << r.snapshot_bytes << ", \"snapshot_save_us\": " << r.snapshot_save_us << ", \"snapshot_load_us\": " << r.snapshot_load_us
+				<< ", \"snapshot_verify_us\": " << r.snapshot_verify_us << ", \"snapshot_mismatches\": " << r.snapshot_mismatches
+				<< ", \"landmarks\": " << r.landmarks << ", \"landmarks_us\": " << r.landmarks_us << ", \"landmark_memory\": " << r.landmark_memory
+				<< ", \"alt_search_us\": " << r.alt_search_us << ", \"alt_expanded\": " << r.alt_expanded << ", \"alt_mismatches\": " << r.alt_mismatches
+				<< ", \"hpa_build_us\": " << r.hpa_build_us << ", \"hpa_memory\": " << r.hpa_memory << ", \"hpa_search_us\": " << r.hpa_search_us
+				<< ", \"hpa_expanded\": " << r.hpa_expanded << ", \"hpa_path_cost\": " << r.hpa_path_cost << ", \"hpa_mismatches\": " << r.hpa_mismatches
+				<< ", \"drags\": " << r.drags << ", \"drag_us\": " << r.drag_us << ", \"drag_rebuilds\": " << r.drag_rebuilds
+				<< ", \"hpa_update_us\": " << r.hpa_update_us << ", \"hpa_updated_clusters\": " << r.hpa_updated_clusters
+				<< ", \"cache_first_us\": " << r.cache_first_us << ", \"cache_repeat_us\": " << r.cache_repeat_us << ", \"cache_hits\": " << r.cache_hits
+				<< ", \"cache_misses\": " << r.cache_misses << ", \"cache_evictions\": " << r.cache_evictions
+				<< ", \"cache_invalidated\": " << r.cache_invalidated << ", \"cache_invalid_paths\": " << r.cache_invalid_paths
+				<< ", \"snap_us\": " << r.snap_us << ", \"snap_scan_us\": " << r.snap_scan_us << ", \"snap_mismatches\": " << r.snap_mismatches
+				<< ", \"queries\": " << r.queries << ", \"paths_found\": " << r.paths_found
+				<< ", \"expanded\": " << r.expanded << ", \"path_cost\": " << r.path_cost << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+}
+
+long long RunMeshMode(const Scenario& sc, std::ostream& out) {
+
+	std::vector<Result> results;
+	for (int size : sc.sizes) {
+		for (int r = 0; r < sc.repeats; ++r) {
+			std::cerr << "mesh size " << size << ", repeat " << r + 1 << "/" << sc.repeats << "\n";
+			results.push_back(Run(sc, size, r));
+		}
+	}
+	if (sc.format == "json") WriteJSON(out, results);
+	else WriteCSV(out, results);
+
+	long long failures = 0;
+	for (const Result& r : results) failures += (long long)r.sample_violations + r.parallel_mismatches + r.batch_mismatches + r.bidi_mismatches + r.metrics_mismatches
+			+ r.snapshot_mismatches + r.alt_mismatches + r.hpa_mismatches + r.cache_invalid_paths + r.snap_mismatches;
+	return failures;
+}
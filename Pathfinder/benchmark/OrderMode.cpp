@@ -0,0 +1,153 @@
+// --mode order: triangulates each mesh twice, inserting the nodes by id and in BRIO order, and compares the point location walk, the cache 
+// misses of the build where Linux perf counters are available (-1 elsewhere) and the edges 
+
+#include "Benchmark.h"
+
+#include <cstring>
+#include <iterator>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	// one row of --mode order 
+	struct OrderResult {
+		std::string order;
+		int size = 0;
+		unsigned int seed = 0;
+		int repeat = 0;
+		int strips = 1;
+		long long triangulation_us = 0;
+		long long filtering_us = 0;
+		long long walk_steps = 0;
+		long long cache_misses = -1; // -1 if the counter is not available 
+		int edge_mismatches = 0; // edges only one of this build and the id order build has 
+	};
+
+	// hardware cache miss counter of the calling thread, through perf_event_open() on Linux; Read() gives -1 where it could not be opened 
+	class CacheMissCounter {
+		int fd = -1;
+	public:
+		CacheMissCounter() {
+#ifdef __linux__
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.inherit = 1; // the strip workers too 
+			fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+		}
+		~CacheMissCounter() {
+#ifdef __linux__
+			if (fd != -1) close(fd);
+#endif
+		}
+		CacheMissCounter(const CacheMissCounter&) = delete;
+		CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+		void Start() {
+#ifdef __linux__
+			if (fd == -1) return;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+		}
+		long long Stop() {
+#ifdef __linux__
+			if (fd == -1) return -1;
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			long long count = 0;
+			if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+			return count;
+#else
+			return -1;
+#endif
+		}
+	};
+
+	std::vector<OrderResult> RunOrder(const Scenario& sc, int size, int repeat) {
+
+		std::mt19937 gen(sc.seed + repeat);
+		Obstacles obstacles = GenObstacles(sc.width, sc.height, sc.obstacles, sc.obstacle_scale, gen);
+		NavMesh mesh(sc.width, sc.height, size, obstacles, gen(), sc.threads);
+
+		// the same nodes, rebuilt in each order 
+		std::vector<OrderResult> res;
+		std::vector<std::pair<int, int>> by_id;
+		CacheMissCounter counter;
+		for (bool brio : { false, true }) {
+
+			OrderResult row;
+			row.order = brio ? "brio" : "index";
+			row.size = size;
+			row.seed = sc.seed + repeat;
+			row.repeat = repeat;
+
+			mesh.SetBrioOrder(brio);
+			counter.Start();
+			mesh.Remake(sc.width, sc.height, size, obstacles);
+			row.cache_misses = counter.Stop();
+
+			row.strips = mesh.GetBuildTimings().triangulation_strips;
+			row.triangulation_us = mesh.GetBuildTimings().triangulation_us;
+			row.filtering_us = mesh.GetBuildTimings().filtering_us;
+			row.walk_steps = mesh.GetBuildTimings().walk_steps;
+
+			std::vector<std::pair<int, int>> edges = EdgeSet(mesh);
+			if (!brio) by_id = edges;
+			std::vector<std::pair<int, int>> diff;
+			std::set_symmetric_difference(edges.begin(), edges.end(), by_id.begin(), by_id.end(), std::back_inserter(diff));
+			row.edge_mismatches = (int)diff.size();
+			res.push_back(row);
+		}
+		return res;
+	}
+
+	void WriteOrderCSV(std::ostream& out, const std::vector<OrderResult>& results) {
+		out << "order,size,seed,repeat,strips,triangulation_us,filtering_us,walk_steps,cache_misses,edge_mismatches\n";
+		for (const OrderResult& r : results) {
+			out << r.order << ',' << r.size << ',' << r.seed << ',' << r.repeat << ',' << r.strips << ',' << r.triangulation_us << ','
+				<< r.filtering_us << ',' << r.walk_steps << ',' << r.cache_misses << ',' << r.edge_mismatches << '\n';
+		}
+	}
+
+	void WriteOrderJSON(std::ostream& out, const std::vector<OrderResult>& results) {
+		out << "[\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const OrderResult& r = results[i];
+			out << "  {\"order\": \"" << r.order << "\", \"size\": " << r.size << ", \"seed\": " << r.seed << ", \"repeat\": " << r.repeat
+				<< ", \"strips\": " << r.strips << ", \"triangulation_us\": " << r.triangulation_us << ", \"filtering_us\": " << r.filtering_us
+				<< ", \"walk_steps\": " << r.walk_steps << ", \"cache_misses\": " << r.cache_misses << ", \"edge_mismatches\": " << r.edge_mismatches << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+}
+
+long long RunOrderMode(const Scenario& sc, std::ostream& out) {
+
+	std::vector<OrderResult> results;
+	for (int size : sc.sizes) {
+		for (int r = 0; r < sc.repeats; ++r) {
+			std::cerr << "mesh size " << size << ", repeat " << r + 1 << "/" << sc.repeats << "\n";
+			std::vector<OrderResult> rows = RunOrder(sc, size, r);
+			results.insert(results.end(), rows.begin(), rows.end());
+		}
+	}
+	if (sc.format == "json") WriteOrderJSON(out, results);
+	else WriteOrderCSV(out, results);
+
+	long long failures = 0;
+	for (const OrderResult& r : results) failures += r.edge_mismatches;
+	return failures;
+}
@@ -0,0 +1,196 @@
+// --mode render: draws each mesh, with the longest of the query paths, offscreen for --frames frames, a shape per node as the Interface 
+// used to and through a MeshRenderer, still and with a node dragged before every frame; the dragged display must match one built afresh 
+// from the moved mesh. Unlike the other modes it needs a graphics context 
+
+#include "Benchmark.h"
+#include "MeshRenderer.h"
+
+#include <cstring>
+
+namespace {
+
+	// one row of --mode render 
+	struct RenderResult {
+		int size = 0;
+		unsigned int seed = 0;
+		int repeat = 0;
+		int edges = 0;
+		int path_nodes = 0;
+		int frames = 0;
+		long long immediate_frame_us = 0;
+		int immediate_draw_calls = 0; // per frame 
+		long long retained_frame_us = 0;
+		int retained_draw_calls = 0;
+		long long drag_frame_us = 0;
+		long long drag_uploaded_vertices = 0; // per frame 
+		int pixel_mismatches = 0; // between the dragged display and the fresh one 
+	};
+
+	// mean wall time of a frame drawn into texture by frame(), in microseconds; the frames are queued on the GPU, and reading the texture back 
+	// at the end waits for all of them 
+	template <typename Frame>
+	long long TimeFrames(sf::RenderTexture& texture, int frames, Frame frame) {
+		if (frames == 0) return 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int f = 0; f < frames; ++f) {
+			texture.clear();
+			frame();
+			texture.display();
+		}
+		texture.getTexture().copyToImage();
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+	}
+
+	RenderResult RunRender(const Scenario& sc, int size, int repeat) {
+
+		RenderResult res;
+		res.size = size;
+		res.seed = sc.seed + repeat;
+		res.repeat = repeat;
+		res.frames = sc.frames;
+
+		std::mt19937 gen(res.seed);
+		Obstacles obstacles = GenObstacles(sc.width, sc.height, sc.obstacles, sc.obstacle_scale, gen);
+		NavMesh mesh(sc.width, sc.height, size, obstacles, gen(), sc.threads);
+		const NavMesh::Graph& graph = mesh.GetGraph();
+		res.edges = graph.EdgeCount();
+
+		A_Star::SearchContext context;
+		std::vector<int> path;
+		for (const A_Star::Query& query : GenQueries(sc.queries, size, gen)) {
+			std::vector<int> found = A_Star::Find(mesh, query.start, query.destination, context);
+			if (found.size() > path.size()) path.swap(found);
+		}
+		res.path_nodes = (int)path.size();
+		int entry_point = path.empty() ? -1 : path.front();
+		int destination = path.empty() ? -1 : path.back();
+
+		sf::RenderTexture texture;
+		if (!texture.create(sc.width, sc.height)) {
+			std::cerr << "Could not create a render texture\n";
+			return res;
+		}
+
+		// as Interface::UpdateNodes() drew before MeshRenderer: the edges from one vertex vector, then a coloured shape per node 
+		std::unordered_map<int, int> on_path;
+		for (int id : path) on_path[id] = 0;
+		std::vector<sf::Vertex> lines;
+		for (int s = 0; s < graph.NodeCount(); ++s) {
+			for (int k = graph.Begin(s); k < graph.End(s); ++k) {
+				int e = graph.neighbours[k];
+				if (e < s) continue;
+				sf::Color col = on_path.count(s) > 0 && on_path.count(e) > 0 ? sf::Color::Green : sf::Color::Red;
+				lines.push_back(sf::Vertex(graph.Position(s), col));
+				lines.push_back(sf::Vertex(graph.Position(e), col));
+			}
+		}
+		std::vector<sf::CircleShape> shapes(graph.NodeCount(), sf::CircleShape(5.0f));
+		for (int id = 0; id < graph.NodeCount(); ++id) {
+			shapes[id].setOrigin(5.0f, 5.0f);
+			shapes[id].setPosition(graph.Position(id));
+		}
+
+		res.immediate_frame_us = TimeFrames(texture, sc.frames, [&]() {
+			texture.draw(lines.data(), lines.size(), sf::Lines);
+			for (int id = 0; id < graph.NodeCount(); ++id) {
+				if (id == entry_point) shapes[id].setFillColor(sf::Color::Green);
+				else if (id == destination) shapes[id].setFillColor(sf::Color::Yellow);
+				else shapes[id].setFillColor(sf::Color::Red);
+				if (on_path.count(id) > 0 && id != destination) shapes[id].setFillColor(sf::Color::Green);
+				texture.draw(shapes[id]);
+			}
+		});
+		res.immediate_draw_calls = graph.NodeCount() + 1;
+
+		// the first Draw() uploads every vertex, so it is left out 
+		MeshRenderer renderer;
+		renderer.Build(mesh);
+		renderer.SetPath(mesh, path);
+		renderer.SetMarkers(mesh, entry_point, destination);
+		renderer.Draw(texture);
+		res.retained_frame_us = TimeFrames(texture, sc.frames, [&]() { renderer.Draw(texture); });
+		res.retained_draw_calls = renderer.GetStats().draw_calls;
+
+		std::uniform_int_distribution<int> pick(0, graph.NodeCount() - 1);
+		std::uniform_real_distribution<float> nudge(-5.0f, 5.0f);
+		long long move_us = 0;
+		res.drag_frame_us = TimeFrames(texture, sc.frames, [&]() {
+			int id = pick(gen);
+			sf::Vector2f pos = graph.Position(id) + sf::Vector2f(nudge(gen), nudge(gen));
+			auto start = std::chrono::high_resolution_clock::now();
+			bool patched = mesh.MoveNode(id, pos);
+			move_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+			if (patched) renderer.MoveNode(mesh, id);
+			else renderer.Build(mesh);
+			renderer.Draw(texture);
+			res.drag_uploaded_vertices += renderer.GetStats().uploaded_vertices;
+		});
+		if (sc.frames > 0) {
+			res.drag_frame_us = std::max(0LL, res.drag_frame_us - move_us / sc.frames);
+			res.drag_uploaded_vertices /= sc.frames;
+		}
+
+		// without a path every edge has the same colour, so the order the patching left them in does not show 
+		renderer.SetPath(mesh, std::vector<int>());
+		MeshRenderer fresh;
+		fresh.Build(mesh);
+		fresh.SetMarkers(mesh, entry_point, destination);
+
+		sf::Image images[2];
+		MeshRenderer* renderers[2] = { &renderer, &fresh };
+		for (int i = 0; i < 2; ++i) {
+			texture.clear();
+			renderers[i]->Draw(texture);
+			texture.display();
+			images[i] = texture.getTexture().copyToImage();
+		}
+		const sf::Uint8* a = images[0].getPixelsPtr();
+		const sf::Uint8* b = images[1].getPixelsPtr();
+		size_t pixels = (size_t)images[0].getSize().x * images[0].getSize().y;
+		for (size_t p = 0; p < pixels; ++p) if (std::memcmp(a + 4 * p, b + 4 * p, 4) != 0) ++res.pixel_mismatches;
+
+		return res;
+	}
+
+	void WriteRenderCSV(std::ostream& out, const std::vector<RenderResult>& results) {
+		out << "size,seed,repeat,edges,path_nodes,frames,immediate_frame_us,immediate_draw_calls,retained_frame_us,retained_draw_calls,drag_frame_us,drag_uploaded_vertices,pixel_mismatches\n";
+		for (const RenderResult& r : results) {
+			out << r.size << ',' << r.seed << ',' << r.repeat << ',' << r.edges << ',' << r.path_nodes << ',' << r.frames << ','
+				<< r.immediate_frame_us << ',' << r.immediate_draw_calls << ',' << r.retained_frame_us << ',' << r.retained_draw_calls << ','
+				<< r.drag_frame_us << ',' << r.drag_uploaded_vertices << ',' << r.pixel_mismatches << '\n';
+		}
+	}
+
+	void WriteRenderJSON(std::ostream& out, const std::vector<RenderResult>& results) {
+		out << "[\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const RenderResult& r = results[i];
+			out << "  {\"size\": " << r.size << ", \"seed\": " << r.seed << ", \"repeat\": " << r.repeat << ", \"edges\": " << r.edges
+				<< ", \"path_nodes\": " << r.path_nodes << ", \"frames\": " << r.frames
+				<< ", \"immediate_frame_us\": " << r.immediate_frame_us << ", \"immediate_draw_calls\": " << r.immediate_draw_calls
+				<< ", \"retained_frame_us\": " << r.retained_frame_us << ", \"retained_draw_calls\": " << r.retained_draw_calls
+				<< ", \"drag_frame_us\": " << r.drag_frame_us << ", \"drag_uploaded_vertices\": " << r.drag_uploaded_vertices
+				<< ", \"pixel_mismatches\": " << r.pixel_mismatches << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+}
+
+long long RunRenderMode(const Scenario& sc, std::ostream& out) {
+
+	std::vector<RenderResult> results;
+	for (int size : sc.sizes) {
+		for (int r = 0; r < sc.repeats; ++r) {
+			std::cerr << "mesh size " << size << ", repeat " << r + 1 << "/" << sc.repeats << "\n";
+			results.push_back(RunRender(sc, size, r));
+		}
+	}
+	if (sc.format == "json") WriteRenderJSON(out, results);
+	else WriteRenderCSV(out, results);
+
+	long long failures = 0;
+	for (const RenderResult& r : results) failures += r.pixel_mismatches;
+	return failures;
+}
@@ -3,45 +3,26 @@
 #include "NavMesh.h"
 
 
-struct A_Star {
-
-private:
-
-	// Wraps data specific to the A* algorithm 
-	struct Node {
-
-		const NavMesh::NodeData data;
-		Node* parent = nullptr; 
-
-		Node() = default; 
-		Node(const NavMesh::NodeData& d) : data(d) {}
-
-		float h_cost = 0.0f; // distance from this node to destination node
-		float g_cost = 0.0f; // the total cost of the path taken from the start to reach this node 
-
-		void SetHCost(const sf::Vector2f& to_dest) { h_cost = (float)std::sqrt(to_dest.x * to_dest.x + to_dest.y * to_dest.y); }
-	};
-
-public:
-
-	static std::vector<int> Find(const NavMesh& mesh);
-
-};
-
-
-// Binary heap for queueing Nodes in A* 
+// Indexed binary heap for queueing Nodes in A* 
+// T must have a member T::ID of type ID (a non-negative index); the heap records each element's slot under its ID so that DecreaseKey() can find it 
 template <typename T, typename ID>
 struct Heap
 {
 private:
 	int N = 0;
 	std::vector<T*> vect = { nullptr };
+	std::vector<int> position; // slot of every enqueued element in vect, indexed by ID; 0 if not enqueued 
 	bool(*comparator)(T*, T*);
 
 	int GetParent(int index) { return index >> 1; }
 	int GetLeftChild(int index) { return index << 1; }
 	int GetRightChild(int index) { return (index << 1) + 1; }
 
+	void Place(int index, T* el) {
+		vect[index] = el;
+		position[(size_t)el->ID] = index;
+	}
+
 public:
 
 	Heap() = default;
@@ -50,12 +31,28 @@ public:
 	bool Empty() { return N == 0; }
 	int GetSize() { return N; }
 
+	// sizes the position index for IDs in [0, id_count), so that Insert() never has to grow it 
+	void Reserve(size_t id_count) {
+		if (position.size() < id_count) position.resize(id_count, 0);
+		vect.reserve(id_count + 1);
+	}
+
+	// empties the heap but keeps its capacity, for reuse across searches 
+	void Clear() {
+		for (int i = 1; i <= N; ++i) position[(size_t)vect[i]->ID] = 0;
+		vect.resize(1);
+		N = 0;
+	}
+
+	bool Contains(ID id) { return (size_t)id < position.size() && position[(size_t)id] != 0; }
+
 	T* GetRoot() {
 		if (!Empty()) return vect[1];
 		else return nullptr;
 	}
 
 	void Insert(T* el) {
+		if ((size_t)el->ID >= position.size()) position.resize((size_t)el->ID + 1, 0);
 		vect.emplace_back(el);
 		++N;
 		HeapUp(N);
@@ -65,37 +62,297 @@ public:
 
 		if (Empty()) return nullptr;
 
-		std::swap(vect[1], vect[N]);
-		T* val = vect[N];
+		T* val = vect[1];
+		position[(size_t)val->ID] = 0;
+
+		T* last = vect[N];
 		vect.pop_back();
 		--N;
-		HeapDown(1);
+		if (N > 0) {
+			vect[1] = last;
+			HeapDown(1);
+		}
 
 		return val;
 	}
 
-	void HeapUp(int i) {
-		if (i > N || i == 1) return;
+	// restores the ordering after el's key was lowered in place 
+	void DecreaseKey(T* el) {
+		if (Contains(el->ID)) HeapUp(position[(size_t)el->ID]);
+	}
 
-		int index = GetParent(i);
-		if (comparator(vect[i], vect[index])) std::swap(vect[index], vect[i]);
-		HeapUp(index);
+	// both sifts move a hole instead of swapping, and write the displaced element once at its final slot 
+	void HeapUp(int i) {
+		if (i > N || i < 1) return;
+
+		T* el = vect[i];
+		while (i > 1) {
+			int index = GetParent(i);
+			if (!comparator(el, vect[index])) break;
+			Place(i, vect[index]);
+			i = index;
+		}
+		Place(i, el);
 	}
 
 	void HeapDown(int i) {
-		if (i > N) return;
+		if (i > N || i < 1) return;
+
+		T* el = vect[i];
+		while (GetLeftChild(i) <= N) {
+			int child = GetLeftChild(i);
+			if (GetRightChild(i) <= N && comparator(vect[GetRightChild(i)], vect[child])) child = GetRightChild(i);
+			if (!comparator(vect[child], el)) break;
+			Place(i, vect[child]);
+			i = child;
+		}
+		Place(i, el);
+	}
+};
+
+
+// Marks which per-ID entries of a search's state belong to the current search: an entry counts only while its stamp matches the generation, 
+// so starting a new search is O(1). Shared by A_Star's search context and Dijkstra 
+struct Stamps
+{
+private:
+	unsigned int generation = 0;
+	std::vector<unsigned int> stamp;
+
+public:
+
+	// sizes the stamps for IDs in [0, id_count); true if their number changed, which drops every entry. Next() must follow before the 
+	// first search 
+	bool Resize(size_t id_count) {
+		if (stamp.size() == id_count) return false;
+		stamp.assign(id_count, 0);
+		generation = 0;
+		return true;
+	}
+
+	// starts a new search; stamps from a wrapped-around generation could alias the new one, so they are cleared then 
+	void Next() {
+		if (++generation == 0) {
+			std::fill(stamp.begin(), stamp.end(), 0);
+			generation = 1;
+		}
+	}
+
+	bool Current(int id) const { return stamp[(size_t)id] == generation; }
+	void Mark(int id) { stamp[(size_t)id] = generation; }
+};
+
+
+// An element of the queues of the searches that keep no Node per mesh node; ID is whatever the search numbers its nodes by 
+struct KeyedEntry {
+	int ID;
+	float key;
+};
+
+inline bool CompareKeyedEntries(KeyedEntry* e1, KeyedEntry* e2) { return e1->key < e2->key; }
+
+
+// Dijkstra's state over IDs in [0, id_count): distances and parents, stamped per search, and a queue of KeyedEntries 
+// Run() is the whole loop over a graph in compressed sparse row form; searches with their own stopping rules or graphs drive it themselves 
+// through Settle() and Relax(), and queueing by a key other than the distance turns it into A*. Used by HPA_Star, ContractionHierarchy 
+// and NavMesh::BuildLandmarks() 
+class Dijkstra
+{
+	Stamps stamps;
+	std::vector<float> dist;
+	std::vector<int> parent;
+	std::vector<KeyedEntry> entries;
+	Heap<KeyedEntry, int> queue = Heap<KeyedEntry, int>(CompareKeyedEntries);
+
+public:
+
+	Dijkstra() = default;
+	Dijkstra(const Dijkstra&) = delete;
+	Dijkstra& operator=(const Dijkstra&) = delete;
+
+	// starts a new search over IDs in [0, id_count); the arrays only ever grow, so searches over graphs of varying sizes share them 
+	void Reset(size_t id_count) {
+		// the queue still points into the entries, so it is emptied before they are regrown 
+		queue.Clear();
+		if (dist.size() < id_count) {
+			stamps.Resize(id_count);
+			dist.resize(id_count);
+			parent.resize(id_count);
+			entries.resize(id_count);
+		}
+		stamps.Next();
+		queue.Reserve(id_count);
+	}
+
+	bool Reached(int id) const { return stamps.Current(id); }
+
+	// valid only for reached IDs; the source's parent is the from it was relaxed with 
+	float Dist(int id) const { return dist[(size_t)id]; }
+	int Parent(int id) const { return parent[(size_t)id]; }
+
+	// reaches id at distance d through from, queued by key; false if it was already reached no farther 
+	bool Relax(int id, float d, int from, float key) {
+		bool seen = stamps.Current(id);
+		if (seen && d >= dist[(size_t)id]) return false;
+
+		stamps.Mark(id);
+		dist[(size_t)id] = d;
+		parent[(size_t)id] = from;
+		entries[(size_t)id] = { id, key };
+		if (seen) queue.DecreaseKey(&entries[(size_t)id]);
+		else queue.Insert(&entries[(size_t)id]);
+		return true;
+	}
+
+	bool Relax(int id, float d, int from) { return Relax(id, d, from, d); }
+
+	bool Empty() { return queue.Empty(); }
 
-		int prev = i;
-		if (GetLeftChild(i) <= N && comparator(vect[GetLeftChild(i)], vect[i])) prev = GetLeftChild(i);
-		if (GetRightChild(i) <= N && comparator(vect[GetRightChild(i)], vect[prev])) prev = GetRightChild(i);
+	// the key the next Settle() comes off the queue with, infinity once it is empty 
+	float NextKey() { return queue.Empty() ? std::numeric_limits<float>::infinity() : queue.GetRoot()->key; }
 
-		if (prev != i) {
-			std::swap(vect[i], vect[prev]);
-			HeapDown(prev);
+	// takes the queued ID with the lowest key off the queue; the queue must not be empty 
+	int Settle() { return queue.RemoveRoot()->ID; }
+
+	// settles everything reachable from the IDs relaxed so far 
+	void Run(const int* offsets, const int* neighbours, const float* weights) {
+		while (!queue.Empty()) {
+			int u = Settle();
+			for (int k = offsets[u]; k < offsets[u + 1]; ++k) Relax(neighbours[k], dist[(size_t)u] + weights[k], u);
 		}
 	}
 };
 
 
+struct A_Star {
+
+	// estimates the length of the shortest path from node id to the destination; it must never overestimate it, or the paths found are no 
+	// longer the shortest. Infinity marks a node that cannot reach the destination at all, which is then never enqueued. Chosen per SearchContext 
+	typedef float (*Heuristic)(const NavMesh& mesh, int id, int destination_id);
+
+	// straight-line distance, the default 
+	static float Euclidean(const NavMesh& mesh, int id, int destination_id);
+
+	// ALT: the largest lower bound the triangle inequality gives through the mesh's landmarks, and never less than the straight-line distance; 
+	// infinity if a landmark reaches only one of the two nodes. Just the straight-line distance while the mesh has no landmark tables 
+	// (see NavMesh::BuildLandmarks()) 
+	static float Landmarks(const NavMesh& mesh, int id, int destination_id);
+
+	// FORWARD searches from the start only; BIDIRECTIONAL also searches back from the destination (the mesh's edges go both ways) and stops 
+	// once the two searches cannot improve on the best path through a node both have seen. Both find shortest paths; the two searches split 
+	// the heuristic between them, so BIDIRECTIONAL pays off with weak heuristics and long queries rather than with Euclidean. Chosen per SearchContext 
+	enum Mode { FORWARD, BIDIRECTIONAL };
+
+private:
+
+	// Wraps data specific to the A* algorithm; the mesh node itself is only referenced by its index 
+	struct Node {
+
+		const int ID; // index into the NavMesh graph 
+
+		Node(int id) : ID(id) {}
+
+		float h_cost = 0.0f; // distance from this node to destination node
+		float g_cost = 0.0f; // the total cost of the path taken from the start to reach this node 
+
+	};
+
+	static bool CompareNodes(Node* n1, Node* n2) { return n1->h_cost + n1->g_cost < n2->h_cost + n2->g_cost; }
+
+public:
+
+	// per-query counters, filled in by Find() and read back from the context 
+	struct Stats {
+		int expanded = 0; // nodes taken off the queue 
+		int expanded_forward = 0; // of those, by the search from the start 
+		int expanded_backward = 0; // and by the search from the destination, in BIDIRECTIONAL mode 
+		int pushed = 0; // nodes inserted into the queue 
+		int decreased = 0; // cheaper paths found to already enqueued nodes 
+		float cost = 0.0f; // length of the returned path, 0 if none was found 
+	};
+
+	// Search state that persists across Find() calls on meshes of the same size, so that a query allocates nothing once the context is warm 
+	// per-node entries are only valid if their stamp matches the current generation, which makes resetting between queries O(1) 
+	class SearchContext {
+
+		friend struct A_Star;
+
+		enum State : unsigned char { UNSEEN, OPEN, CLOSED };
+
+		Stamps stamps;
+		std::vector<unsigned char> state;
+		std::vector<float> g_cost;
+		std::vector<int> parent;
+		std::vector<Node*> enqueued; // the pooled Node of each open mesh node 
+
+		// at most one Node per mesh node is created in a search, so reserving the node count keeps pointers into the pool stable 
+		std::vector<Node> pool;
+		Heap<Node, int> queue = Heap<Node, int>(CompareNodes);
+
+		Stats stats;
+		Heuristic heuristic = Euclidean;
+		Mode mode = FORWARD;
+
+		// the search from the destination, in BIDIRECTIONAL mode; created by the first such search 
+		std::unique_ptr<SearchContext> backward;
+
+		// sizes the arrays to the mesh and starts a new generation 
+		void Reset(int node_count);
+
+		State GetState(int id) const { return stamps.Current(id) ? (State)state[id] : UNSEEN; }
+		Node* Open(int id, int parent_id, float g, float h);
+
+	public:
+
+		SearchContext() = default;
+		SearchContext(const SearchContext&) = delete;
+		SearchContext& operator=(const SearchContext&) = delete;
+
+		// counters of the last Find() run with this context 
+		const Stats& GetStats() const { return stats; }
+
+		// the heuristic of the following Find() calls 
+		void SetHeuristic(Heuristic h) { heuristic = h; }
+		Heuristic GetHeuristic() const { return heuristic; }
+
+		// the search mode of the following Find() calls 
+		void SetMode(Mode m) { mode = m; }
+		Mode GetMode() const { return mode; }
+	};
+
+	// a start/destination pair for FindBatch() 
+	struct Query {
+		int start;
+		int destination;
+	};
+
+	struct Result {
+		std::vector<int> path; // empty if no path was found 
+		Stats stats;
+	};
+
+private:
+
+	// the two modes of Find(), which reports their stats to the metrics 
+	static std::vector<int> FindForward(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context);
+	static std::vector<int> FindBidirectional(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context);
 
+public:
+
+	// search between the mesh's entry point and destination, with a context kept per thread; a search that finds no path is reported as a 
+	// metrics event 
+	static std::vector<int> Find(const NavMesh& mesh);
+	static std::vector<int> Find(const NavMesh& mesh, SearchContext& context);
+
+	// search between any two nodes; only reads the mesh, so concurrent calls are safe as long as each uses its own context 
+	static std::vector<int> Find(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context);
+
+	// answers count queries on thread_count worker threads (0 picks the hardware concurrency), each with its own context 
+	// results are in query order; the mesh must not be modified while the batch runs 
+	static std::vector<Result> FindBatch(const NavMesh& mesh, const Query* queries, size_t count, unsigned int thread_count = 0, Heuristic heuristic = Euclidean);
+	static std::vector<Result> FindBatch(const NavMesh& mesh, const std::vector<Query>& queries, unsigned int thread_count = 0, Heuristic heuristic = Euclidean) {
+		return FindBatch(mesh, queries.data(), queries.size(), thread_count, heuristic);
+	}
+
+};
 
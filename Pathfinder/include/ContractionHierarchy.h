@@ -0,0 +1,83 @@
+#pragma once
+
+#include "AStar.h"
+
+
+// Contraction hierarchy over a NavMesh graph, for meshes that stay the same between Remake() calls 
+// Build() contracts the nodes one at a time, least important first, and adds a shortcut between two neighbours of a contracted node whenever 
+// the path through it is the only shortest one; every node then keeps only its edges to more important nodes. A query searches upwards 
+// from both ends over those edges alone and meets at the most important node of the shortest path, which is tiny compared with A*'s search 
+// the shortcuts on the way are unpacked back into mesh nodes, so Find() returns the same kind of path as A_Star::Find(). Paths are shortest 
+// the hierarchy does not follow the mesh: after Remake() or MoveNode() it must be built again 
+class ContractionHierarchy {
+
+public:
+
+	// the work of the last Find() through a context 
+	struct Stats {
+		int expanded = 0; // nodes taken off either queue 
+		float cost = 0.0f; // length of the returned path, 0 if none was found 
+	};
+
+private:
+
+	int node_count = 0;
+	int shortcut_count = 0;
+	std::vector<int> rank; // contraction order of every node 
+
+	// the upward edges of every node, to nodes of higher rank, in compressed sparse row form; middle is the contracted node a shortcut 
+	// bypasses, -1 for a mesh edge 
+	std::vector<int> offsets;
+	std::vector<int> targets;
+	std::vector<float> weights;
+	std::vector<int> middles;
+
+	// index of the upward edge from from to to, -1 if there is none 
+	int FindEdge(int from, int to) const;
+
+	// appends the mesh nodes after x up to y, along upward edge k between them (stored at the lower of the two) 
+	void Unpack(int x, int y, int k, std::vector<int>& path) const;
+
+public:
+
+	// The two upward searches of a query, kept between queries so that their arrays are sized once per mesh 
+	class SearchContext {
+
+		friend class ContractionHierarchy;
+
+		// forward (from the start) and backward (from the destination); parent_edge is the upward edge each node was reached by 
+		struct Side {
+			Dijkstra search;
+			std::vector<int> parent_edge;
+		};
+
+		Side sides[2];
+		Stats stats;
+
+		void Reset(int node_count);
+
+	public:
+
+		SearchContext() = default;
+		SearchContext(const SearchContext&) = delete;
+		SearchContext& operator=(const SearchContext&) = delete;
+
+		const Stats& GetStats() const { return stats; }
+	};
+
+	ContractionHierarchy() = default;
+
+	// orders and contracts the nodes of the mesh; replaces whatever the hierarchy held 
+	void Build(const NavMesh& mesh);
+
+	// shortest path between two nodes, as A_Star::Find() returns it; only reads the hierarchy, so concurrent calls are safe as long as each 
+	// uses its own context 
+	std::vector<int> Find(int start_id, int destination_id, SearchContext& context) const;
+
+	int GetNodeCount() const { return node_count; }
+	int GetShortcutCount() const { return shortcut_count; }
+
+	// bytes held by the ranks and the upward edges 
+	size_t GetMemoryUsage() const;
+
+};
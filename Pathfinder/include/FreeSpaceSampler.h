@@ -0,0 +1,74 @@
+#pragma once
+
+#include "includes.h"
+
+
+// Uniform random points in the part of a w x h area that lies farther than a clearance from every obstacle, without retrying blindly: the 
+// area is cut into equal cells once, and every cell is classified from the obstacles as free, blocked or partly covered. Points are only 
+// drawn from free and partly covered cells, and only those falling in a partly covered cell are tested against the obstacles (and drawn 
+// again if they are inside one), so the expected work per point depends on the length of the obstacle outlines rather than on the share 
+// of the area they cover. The total number of draws is capped, so a sample that does not fit ends early with fewer points 
+class FreeSpaceSampler {
+
+public:
+
+	// draws per requested point that Sample() may spend in all, before it gives up on the rest 
+	static const int ATTEMPTS_PER_POINT = 30;
+
+	// counters over every Sample() so far 
+	struct Stats {
+		long long attempts = 0;
+		int rejected_obstacle = 0; // drawn in a partly covered cell, within the clearance of an obstacle 
+		int rejected_spacing = 0; // closer than the minimum spacing to an earlier point 
+	};
+
+private:
+
+	enum CellState : unsigned char { FREE, PARTIAL, BLOCKED };
+
+	float width = 0.0f;
+	float height = 0.0f;
+	float clearance = 0.0f;
+
+	// the obstacles grown by the clearance: min x, min y, max x, max y 
+	std::vector<float> bounds;
+
+	int cols = 0;
+	int rows = 0;
+	float cell_w = 0.0f;
+	float cell_h = 0.0f;
+	std::vector<CellState> cells;
+
+	// the free and partly covered cells, drawn from with equal probability since the cells are all the same size 
+	std::vector<int> candidates;
+	int free_cells = 0;
+
+	// the obstacles overlapping each partly covered cell, obstacle_items[obstacle_start[c]] up to obstacle_items[obstacle_start[c + 1]] 
+	std::vector<int> obstacle_start;
+	std::vector<int> obstacle_items;
+
+	mutable Stats stats;
+
+	bool Blocked(sf::Vector2f pt, int cell) const;
+
+public:
+
+	// obstacles are (top-left corner, size) pairs, as NavMesh takes them; about cell_target cells are laid over the area 
+	FreeSpaceSampler(int sc_w, int sc_h, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles, float clearance, int cell_target = 4096);
+
+	// one uniformly distributed free point, false if none was found within ATTEMPTS_PER_POINT draws 
+	bool Sample(std::mt19937& gen, sf::Vector2f& pt) const;
+
+	// up to count free points; with min_spacing > 0, no two of them are closer than it (dart throwing, for blue noise) 
+	std::vector<sf::Vector2f> Sample(std::mt19937& gen, int count, float min_spacing = 0.0f) const;
+
+	// true if pt is outside the area or within the clearance of an obstacle 
+	bool Blocked(sf::Vector2f pt) const;
+
+	// the share of the area that is certainly free, and the share that needs testing point by point 
+	float GetFreeFraction() const { return cells.empty() ? 0.0f : (float)free_cells / cells.size(); }
+	float GetPartialFraction() const { return cells.empty() ? 0.0f : (float)(candidates.size() - free_cells) / cells.size(); }
+
+	const Stats& GetStats() const { return stats; }
+
+};
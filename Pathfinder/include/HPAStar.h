@@ -0,0 +1,134 @@
+#pragma once
+
+#include "AStar.h"
+
+
+// Hierarchical path-finding layer (HPA*) over a NavMesh graph 
+// the nodes are grouped into clusters by a uniform grid, and each cluster into regions, its connected parts; between every two neighbouring 
+// regions a few of the edges joining them are picked as portals, and the distances between the portals of a region are precomputed, along 
+// with the shortest path trees they come from. A query searches the small graph of portals first, then expands its hops into mesh paths 
+// through the trees, so it only ever touches the clusters along its corridor. Paths are near-optimal rather than optimal 
+class HPA_Star {
+
+public:
+
+	// what the last Find() through a context did 
+	struct Stats {
+		int expanded = 0; // portals (and the start and destination) taken off the queue of the abstract search 
+		float cost = 0.0f; // length of the returned path, 0 if none was found 
+	};
+
+private:
+
+	// a picked edge from a portal of a region to a node of a neighbouring region (itself a portal there) 
+	struct Link {
+		int portal; // index into the region's portals 
+		int node; // mesh id of the far end 
+		float weight;
+	};
+
+	struct Region {
+		std::vector<int> nodes; // mesh ids, ascending 
+
+		// the edges inside the region, over local indices, in compressed sparse row form 
+		std::vector<int> offsets;
+		std::vector<int> neighbours;
+		std::vector<float> weights;
+
+		std::vector<int> portals; // local indices into nodes, ascending 
+		std::vector<Link> links;
+
+		// portal x portal distances within the region, and per portal, the parent of every local node on its shortest path tree (-1 at the root) 
+		std::vector<float> distances;
+		std::vector<int> parents;
+	};
+
+	struct Cluster {
+		std::vector<int> nodes; // mesh ids, ascending 
+		unsigned long long fingerprint = 0; // of the nodes, their positions and their graph rows 
+		std::vector<int> neighbours; // clusters joined to this one by an edge, as of its last rebuild 
+		std::vector<Region> regions;
+	};
+
+	int cluster_nodes; // the average number of nodes per cluster aimed for 
+
+	// the grid, fixed by Build() 
+	float min_x = 0.0f, min_y = 0.0f;
+	float cell_w = 1.0f, cell_h = 1.0f;
+	int cells_x = 0, cells_y = 0;
+
+	int node_count = -1;
+	std::vector<Cluster> clusters;
+	std::vector<int> node_cluster;
+	std::vector<int> node_region; // index into its cluster's regions 
+	std::vector<int> node_local; // index into its region's nodes 
+
+	// the abstract graph over all portals, in compressed sparse row form; rebuilt whole by every Update() that changes a cluster 
+	std::vector<int> abstract_of; // per mesh node, its abstract id, -1 unless it is a portal 
+	std::vector<int> abstract_node; // mesh id of every abstract node 
+	std::vector<float> abstract_xs, abstract_ys;
+	std::vector<int> offsets;
+	std::vector<int> targets;
+	std::vector<float> weights;
+
+	// Build() and Update() working state 
+	Dijkstra search;
+
+	int CellOf(sf::Vector2f pos) const;
+	unsigned long long Fingerprint(const NavMesh::Graph& graph, const std::vector<int>& nodes) const;
+
+	// splits a cluster into its regions and numbers its nodes; the portals are left to BuildRegions() 
+	void LabelRegions(const NavMesh::Graph& graph, int c);
+
+	// picks the portals of a cluster's regions and computes their distance tables; needs the regions of the neighbouring clusters 
+	void BuildRegions(const NavMesh::Graph& graph, int c);
+
+	void BuildAbstractGraph(const NavMesh::Graph& graph);
+
+	// Dijkstra from a local node over the region; search holds the local distances and parents after 
+	static void SearchRegion(const Region& region, int root, Dijkstra& search);
+
+public:
+
+	// The three searches of a query: A* over the portals, and Dijkstra inside the start's and the destination's regions; one context per 
+	// thread, reused from query to query 
+	class SearchContext {
+
+		friend class HPA_Star;
+
+		Dijkstra search; // over the abstract ids, with the start and the destination after the portals 
+		Dijkstra start_search, destination_search; // over region-local indices 
+
+		Stats stats;
+
+		void Reset(int abstract_count);
+
+	public:
+
+		SearchContext() = default;
+		SearchContext(const SearchContext&) = delete;
+		SearchContext& operator=(const SearchContext&) = delete;
+
+		const Stats& GetStats() const { return stats; }
+	};
+
+	explicit HPA_Star(int cluster_nodes = 256) : cluster_nodes(cluster_nodes) {}
+
+	// lays the grid over the mesh and precomputes every cluster 
+	void Build(const NavMesh& mesh);
+
+	// catches up with the mesh after Remake() or MoveNode(): only the clusters whose nodes or edges changed, and their neighbours, are 
+	// precomputed again; a mesh with a different node count is built from scratch. Returns the number of clusters precomputed 
+	int Update(const NavMesh& mesh);
+
+	// search between two nodes of the mesh the hierarchy is up to date with; only reads the hierarchy, so concurrent calls are safe as long 
+	// as each uses its own context 
+	std::vector<int> Find(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context) const;
+
+	int GetClusterCount() const { return (int)clusters.size(); }
+	int GetPortalCount() const { return (int)abstract_node.size(); }
+
+	// bytes held by the precomputed tables and the abstract graph 
+	size_t GetMemoryUsage() const;
+
+};
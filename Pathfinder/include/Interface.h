@@ -1,6 +1,8 @@
 #pragma once
 
 #include "AStar.h"
+#include "MeshRenderer.h"
+#include "Metrics.h"
 #include "NavMesh.h"
 
 class Interface
@@ -37,28 +39,13 @@ private:
 		}
 	};
 
-	// Wraps data for drawing NavMesh::Node 
-	struct Node {
-
-		sf::CircleShape shape;
-		const float radius; 
-
-		Node(sf::Vector2f pos) : radius(5.0f), shape(5.0f) {
-			shape.setOrigin(radius, radius);
-			shape.setPosition(pos);
-		}
-		bool Contains(sf::Vector2i pt) const { 
-			sf::Vector2f ptf = sf::Vector2f((float)pt.x, (float)pt.y);
-			sf::Vector2f diff = ptf - shape.getPosition(); 
-			return std::sqrt(diff.x * diff.x + diff.y * diff.y) <= radius; 
-		}
+	std::vector<Obstacle> obstacles;
 
-	};
+	// the nodes, edges and path, drawn in two calls per frame; see MeshRenderer 
+	MeshRenderer renderer;
 
-	std::vector<Node> nodes;
-	std::vector<Obstacle> obstacles;
-	std::vector<sf::Vertex> edges; 
-	std::unordered_map<int, int> path; 
+	// prints the timings and outcomes of the builds and searches while the interface is up 
+	Metrics::Console console;
 	
 	// Asks the user for the desired mesh size 
 	void SetMeshSize();
@@ -69,12 +56,8 @@ private:
 	// Get obstacle origin (pair.first) and its width and height (pair.second) for defining valid nodes
 	std::vector<std::pair<sf::Vector2f, sf::Vector2f>> GetObstacleData();
 
-	// Get the NavMesh nodes and edges to interact with/draw 
-	void GetNodesInterface(); 
-	void GetEdgeDisplay();
-
 	// Build the path-map found by the pathfinding algorithm for display in Update()
-	void GetPath(std::vector<int> p);
+	void GetPath(const std::vector<int>& p);
 
 	// Update the nodes interface (selecting start/finish and dragging nodes) and draw, called in Update()
 	void UpdateNodes(sf::RenderWindow& win);
@@ -84,26 +67,11 @@ private:
 
 public:
 
-	Interface() { std::cout << "Press SPACE to generate the obstacles\n\n"; start = std::chrono::high_resolution_clock::now(); }
+	Interface() { std::cout << "Press SPACE to generate the obstacles\n\n"; start = std::chrono::high_resolution_clock::now(); Metrics::AddSink(&console); }
+	~Interface() { Metrics::RemoveSink(&console); }
 
 	// main update function 
 	void Update(sf::RenderWindow& win);
 
-	void Test(sf::RenderWindow& win) {
-		SetMeshSize();
-		std::chrono::steady_clock::time_point start = std::chrono::high_resolution_clock::now();
-		for (int i = 0; i < 1000; ++i) {
-			Reset();
-			GetObstacleDisplay(win.getSize().x, win.getSize().y);
-			nav_mesh = nav_mesh = new NavMesh(win.getSize().x, win.getSize().y, mesh_size, GetObstacleData());
-			nav_mesh->RandomStart();
-			nav_mesh->RandomEnd();
-			A_Star::Find(*nav_mesh);
-			std::cout << i << "\n";
-		}
-		Reset();
-		std::cout << "Test finished in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << " milliseconds\n\n";
-	}
-
 };
 
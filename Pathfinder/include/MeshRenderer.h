@@ -0,0 +1,98 @@
+#pragma once
+
+#include "NavMesh.h"
+
+
+// Retained drawing of a NavMesh: every node is a textured quad and every edge a line, all kept in two vertex arrays that are drawn with one 
+// call each, from vertex buffers on the GPU where the driver supports them. Nothing is rebuilt per frame; the path, the start and destination 
+// markers and MoveNode() only rewrite the vertices of the nodes and edges they change, and only those are uploaded by the next Draw() 
+class MeshRenderer {
+
+public:
+
+	// counters of the last Draw() 
+	struct Stats {
+		int draw_calls = 0;
+		int uploads = 0; // runs of adjacent dirty vertices copied into the buffers 
+		int uploaded_vertices = 0;
+	};
+
+private:
+
+	static const int NODE_VERTICES = 6; // two triangles per quad 
+
+	float node_radius;
+
+	// the circle the node quads are textured with, white so that the vertex colours tint it 
+	sf::Texture node_texture;
+
+	std::vector<sf::Vertex> node_vertices;
+	std::vector<sf::Vertex> edge_vertices;
+
+	// the (lower id, higher id) pair of every edge in edge_vertices, in the same order, and the index of each pair, for patching after MoveNode() 
+	std::vector<std::pair<int, int>> edge_ids;
+	std::unordered_map<long long, int> edge_slots;
+
+	// per node, whether it is on the path, and the nodes it is set for 
+	std::vector<bool> on_path;
+	std::vector<int> path_nodes;
+	int entry_point_id = -1;
+	int destination_id = -1;
+
+	// vertex buffers mirroring the arrays, and the vertices they hold; the arrays are drawn directly where vertex buffers are unavailable 
+	bool use_buffers = false;
+	sf::VertexBuffer node_buffer;
+	sf::VertexBuffer edge_buffer;
+	size_t node_capacity = 0;
+	size_t edge_capacity = 0;
+
+	// slots (nodes, edges) rewritten since the last Draw(), each listed once 
+	std::vector<int> dirty_nodes;
+	std::vector<int> dirty_edges;
+	std::vector<bool> node_dirty;
+	std::vector<bool> edge_dirty;
+	bool full_upload = true;
+
+	Stats stats;
+
+	static long long EdgeKey(int s, int e) { return ((long long)s << 32) | e; }
+
+	sf::Color NodeColour(int id) const;
+	sf::Color EdgeColour(int s, int e) const { return on_path[s] && on_path[e] ? sf::Color::Green : sf::Color::Red; }
+
+	void WriteNode(int id, sf::Vector2f pos);
+	void WriteEdge(int slot, sf::Vector2f s_pos, sf::Vector2f e_pos, sf::Color col);
+	void RecolourNode(const NavMesh& mesh, int id, bool edges);
+
+	// copies the dirty runs of vertices into buffer, or all of them (recreating it if it is too small) 
+	void Upload(sf::VertexBuffer& buffer, size_t& capacity, const std::vector<sf::Vertex>& vertices, std::vector<int>& dirty, std::vector<bool>& flags, int vertices_per_slot);
+
+public:
+
+	explicit MeshRenderer(float node_radius = 5.0f);
+
+	MeshRenderer(const MeshRenderer&) = delete;
+	MeshRenderer& operator=(const MeshRenderer&) = delete;
+
+	// (re)writes every node and edge of the mesh, keeping the path if the node count is unchanged 
+	void Build(const NavMesh& mesh);
+
+	// patches the display after a successful mesh.MoveNode(id, ...) from the mesh's edge changes 
+	void MoveNode(const NavMesh& mesh, int id);
+
+	// marks the nodes of path (and the edges between them) as on the path, in place of the previous path 
+	void SetPath(const NavMesh& mesh, const std::vector<int>& path);
+
+	// the start and destination colours; cheap to call every frame 
+	void SetMarkers(const NavMesh& mesh, int entry_point, int destination);
+
+	// empties the display 
+	void Clear();
+
+	// uploads the dirty vertices and draws the edges, then the nodes 
+	void Draw(sf::RenderTarget& target);
+
+	float GetNodeRadius() const { return node_radius; }
+	const Stats& GetStats() const { return stats; }
+
+};
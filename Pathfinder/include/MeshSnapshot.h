@@ -0,0 +1,114 @@
+#pragma once
+
+#include "NavMesh.h"
+
+#include <cstdint> // fixed-width fields of the file format
+#include <string>
+
+
+// Versioned binary image of a NavMesh: a fixed header, then node positions, the CSR adjacency, an edge list and the obstacle rectangles, each 
+// in its own 64-byte aligned section of native little-endian arrays. Open() maps the file read-only and only checks the header, so the 
+// sections can be read in place straight from the mapping (their pages are faulted in as they are touched); Verify() reads everything to 
+// check the checksum and the adjacency. NavMesh::Save() writes one, and the NavMesh snapshot constructor loads one without triangulating 
+class MeshSnapshot {
+
+public:
+
+	static const std::uint32_t FORMAT_VERSION = 2;
+
+	enum SectionID { XS, YS, OFFSETS, NEIGHBOURS, WEIGHTS, EDGES, OBSTACLES, SECTION_COUNT };
+
+	// byte range of a section, from the start of the file 
+	struct Section {
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	struct Header {
+		char magic[8]; // "NAVMESH" and a terminating zero 
+		std::uint32_t format_version;
+		std::uint32_t byte_order; // BYTE_ORDER_MARK as written, so that a machine of the other endianness rejects the file 
+		std::uint32_t node_count;
+		std::uint32_t edge_count;
+		std::uint32_t obstacle_count;
+		std::int32_t width; // the mesh area, as given to the NavMesh constructor 
+		std::int32_t height;
+		std::int32_t entry_point_id;
+		std::int32_t destination_id;
+		std::uint32_t reserved;
+		std::uint64_t file_size;
+		std::uint64_t checksum; // of the whole file, this field taken as zero 
+		Section sections[SECTION_COUNT];
+	};
+
+	// the lower id first, once per edge 
+	struct Edge {
+		std::int32_t lo;
+		std::int32_t hi;
+		float weight;
+	};
+
+	// top-left corner and size, as NavMesh takes them 
+	struct Obstacle {
+		float x;
+		float y;
+		float w;
+		float h;
+	};
+
+	static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+private:
+
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	bool mapped = false; // false if the file was read into buffer instead, where it cannot be mapped 
+	std::vector<std::uint64_t> buffer;
+	std::string error;
+
+	bool Fail(const std::string& message);
+
+public:
+
+	MeshSnapshot() = default;
+	~MeshSnapshot() { Close(); }
+
+	MeshSnapshot(const MeshSnapshot&) = delete;
+	MeshSnapshot& operator=(const MeshSnapshot&) = delete;
+
+	// writes mesh's graph, obstacles and start / destination to path; false if the file could not be written 
+	static bool Write(const NavMesh& mesh, const std::string& path);
+
+	// word-wise FNV-1a over size bytes (a multiple of 8), continuing from the checksum of whatever came before them, if given 
+	static std::uint64_t Checksum(const unsigned char* bytes, size_t size, std::uint64_t previous = 0xcbf29ce484222325ull);
+
+	// maps path and checks the header and the section bounds, leaving the snapshot closed (see GetError()) if they are wrong 
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const { return data != nullptr; }
+
+	// reads the whole file: true if the checksum matches and the adjacency and edges only name existing nodes 
+	bool Verify();
+
+	bool IsMapped() const { return mapped; }
+	size_t GetSize() const { return size; }
+	const std::string& GetError() const { return error; }
+
+	const Header& GetHeader() const { return *reinterpret_cast<const Header*>(data); }
+	int NodeCount() const { return (int)GetHeader().node_count; }
+	int EdgeCount() const { return (int)GetHeader().edge_count; }
+	int ObstacleCount() const { return (int)GetHeader().obstacle_count; }
+
+	// the sections, in place 
+	template <typename T>
+	const T* Get(SectionID id) const { return reinterpret_cast<const T*>(data + GetHeader().sections[id].offset); }
+
+	const float* Xs() const { return Get<float>(XS); }
+	const float* Ys() const { return Get<float>(YS); }
+	const std::int32_t* Offsets() const { return Get<std::int32_t>(OFFSETS); }
+	const std::int32_t* Neighbours() const { return Get<std::int32_t>(NEIGHBOURS); }
+	const float* Weights() const { return Get<float>(WEIGHTS); }
+	const Edge* Edges() const { return Get<Edge>(EDGES); }
+	const Obstacle* Obstacles() const { return Get<Obstacle>(OBSTACLES); }
+
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "includes.h"
+
+#include <string>
+
+
+// Counters, histograms and events of the searches and the mesh builds, passed on to whichever sinks are installed instead of being printed. 
+// The hot paths count into their own stats (A_Star::Stats, the triangulation's counters) and report once per search or build, so an 
+// installed sink costs a few calls per query, and none at all costs a scan of an empty sink table. Defining PATHFINDER_NO_METRICS compiles 
+// every METRICS_* statement out, with the clock reads behind them 
+class Metrics {
+
+public:
+
+	enum Counter {
+		PATHS_FOUND,
+		PATHS_NOT_FOUND,
+		NODES_EXPANDED, // nodes taken off the queue, which are also the heap pops 
+		HEAP_PUSHES,
+		HEAP_DECREASES, // cheaper paths found to nodes already in the queue 
+		POINT_INSERTIONS, // points inserted into a triangulation, by builds and moves 
+		CIRCLE_TESTS, // in-circle tests of the triangles around an insertion's cavity 
+		WALK_STEPS, // triangles crossed by point location 
+		EDGES_TESTED, // mesh edges checked against the obstacles 
+		EDGES_REJECTED, // of those, the edges that cross an obstacle 
+		ARENA_ALLOCATIONS, // blocks the triangulator's scratch arenas took from the heap 
+		COUNTER_COUNT
+	};
+
+	// the durations are in microseconds 
+	enum Histogram {
+		SEARCH_US, // one A* query 
+		SAMPLING_US,
+		TRIANGULATION_US,
+		FILTERING_US,
+		UPDATE_US, // one NavMesh::MoveNode() 
+		LANDMARKS_US,
+		LOAD_US, // a mesh loaded from a snapshot 
+		CAVITY_SIZE, // triangles replaced by one point insertion 
+		HISTOGRAM_COUNT
+	};
+
+	// histogram buckets by powers of two: bucket 0 holds 0 (and negative values), bucket b the values in [2^(b - 1), 2^b), the last one the rest 
+	static const int BUCKETS = 40;
+
+	// receives everything recorded while it is installed; the calls may come from several threads at once (A_Star::FindBatch()) 
+	class Sink {
+	public:
+		virtual ~Sink() = default;
+		virtual void Count(Counter /*counter*/, long long /*amount*/) {}
+		// times observations of value 
+		virtual void Observe(Histogram /*histogram*/, long long /*value*/, long long /*times*/) {}
+		// progress and outcomes, as the console used to show them 
+		virtual void Event(const std::string& /*text*/) {}
+	};
+
+	// a sink that adds everything up, for reading the numbers in code 
+	class Totals : public Sink {
+
+	public:
+
+		struct HistogramData {
+			long long count = 0;
+			long long sum = 0;
+			long long max = 0;
+			long long buckets[BUCKETS] = {};
+		};
+
+	private:
+
+		std::atomic<long long> counters[COUNTER_COUNT];
+		std::atomic<long long> counts[HISTOGRAM_COUNT];
+		std::atomic<long long> sums[HISTOGRAM_COUNT];
+		std::atomic<long long> maxima[HISTOGRAM_COUNT];
+		std::atomic<long long> buckets[HISTOGRAM_COUNT][BUCKETS];
+		std::atomic<long long> events;
+
+	public:
+
+		Totals() { Reset(); }
+
+		void Count(Counter counter, long long amount) override;
+		void Observe(Histogram histogram, long long value, long long times) override;
+		void Event(const std::string& /*text*/) override { events.fetch_add(1, std::memory_order_relaxed); }
+
+		// not to be called while a search or a build may record into this sink 
+		void Reset();
+
+		long long GetCount(Counter counter) const { return counters[counter].load(std::memory_order_relaxed); }
+		HistogramData GetHistogram(Histogram histogram) const;
+		long long GetEvents() const { return events.load(std::memory_order_relaxed); }
+
+	};
+
+	// prints the events and the durations; the counters and the other histograms are left out, there being one of them per query or point 
+	class Console : public Sink {
+	public:
+		void Observe(Histogram histogram, long long value, long long times) override;
+		void Event(const std::string& text) override;
+	};
+
+	// most sinks installed at once 
+	static const int MAX_SINKS = 8;
+
+private:
+
+	static std::atomic<Sink*> sinks[MAX_SINKS];
+
+public:
+
+	// installs sink, which must outlive its installation; false if MAX_SINKS are installed already 
+	static bool AddSink(Sink* sink);
+	static void RemoveSink(Sink* sink);
+
+	static void Count(Counter counter, long long amount = 1);
+	static void Observe(Histogram histogram, long long value, long long times = 1);
+	static void Event(const std::string& text);
+
+	static int Bucket(long long value);
+	static const char* Name(Counter counter);
+	static const char* Name(Histogram histogram);
+
+	// observes the microseconds from its construction to its destruction 
+	class ScopedTimer {
+		Histogram histogram;
+		std::chrono::high_resolution_clock::time_point start;
+	public:
+		explicit ScopedTimer(Histogram histogram) : histogram(histogram), start(std::chrono::high_resolution_clock::now()) {}
+		~ScopedTimer() { Observe(histogram, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count()); }
+	};
+
+};
+
+#ifndef PATHFINDER_NO_METRICS
+#define METRICS_COUNT(counter, amount) Metrics::Count(Metrics::counter, (amount))
+#define METRICS_OBSERVE(histogram, value) Metrics::Observe(Metrics::histogram, (value))
+#define METRICS_OBSERVE_TIMES(histogram, value, times) Metrics::Observe(Metrics::histogram, (value), (times))
+#define METRICS_EVENT(text) Metrics::Event(text)
+#define METRICS_TIMER(histogram) Metrics::ScopedTimer metrics_timer_##histogram(Metrics::histogram)
+#else
+#define METRICS_COUNT(counter, amount) ((void)0)
+#define METRICS_OBSERVE(histogram, value) ((void)0)
+#define METRICS_OBSERVE_TIMES(histogram, value, times) ((void)0)
+#define METRICS_EVENT(text) ((void)0)
+#define METRICS_TIMER(histogram) ((void)0)
+#endif
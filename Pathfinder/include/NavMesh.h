@@ -2,23 +2,164 @@
 
 #include "includes.h"
 
+// defined in Bowyer-Watson.c 
+struct ScratchArena;
+struct Triangulation;
+struct ObstacleGrid;
+
+class MeshSnapshot;
+
 class NavMesh
 {
+public:
+
+	// how far from an obstacle a node must lie; closer points are neither sampled nor treated as free 
+	static constexpr float OBSTACLE_CLEARANCE = 5.0f;
+
+	// durations of the mesh construction phases, in microseconds; sampling is set by the constructor, update by MoveNode(), the rest by every Remake() 
+	struct BuildTimings {
+		long long sampling_us = 0;
+		int sampling_rejections = 0; // points the constructor drew again, within an obstacle's clearance or closer than min_spacing to a node 
+		long long triangulation_us = 0;
+		long long filtering_us = 0;
+		long long update_us = 0; // the last MoveNode() 
+		int triangulation_strips = 1; // strips the last Remake() triangulated in parallel, 1 if it ran serially 
+		long long merge_us = 0; // of triangulation_us, the serial merge of those strips; 0 if there were none 
+		long long walk_steps = 0; // triangles the last Remake()'s point location walked across, over all strips 
+		long long landmarks_us = 0; // the last BuildLandmarks(), also run by Remake() 
+		long long load_us = 0; // copying the mesh out of a snapshot, set by the snapshot constructor instead of the three build phases 
+	};
+
+	// ALT landmark tables, for A_Star::Landmarks(): the shortest path length from each of count landmark nodes to every node, stored node-major 
+	// so that the count distances of a node are adjacent 
+	struct LandmarkTable {
+		static constexpr float UNREACHABLE = -1.0f;
+
+		int count = 0;
+		std::vector<int> landmarks;
+		std::vector<float> distances;
+
+		bool Valid() const { return count > 0; }
+		const float* Row(int id) const { return distances.data() + (size_t)id * count; }
+		size_t GetMemoryUsage() const { return sizeof(int) * landmarks.size() + sizeof(float) * distances.size(); }
+	};
+
+	// edges that the last MoveNode() took out of and put into the graph, as (lower id, higher id) pairs; an edge of the moved node that survived the move is in both 
+	struct EdgeChanges {
+		std::vector<std::pair<int, int>> removed;
+		std::vector<std::pair<int, int>> added;
+	};
+
+	// Compact, read-only adjacency of the mesh in compressed sparse row form, rebuilt at the end of every Remake() 
+	// the neighbours of node i are neighbours[offsets[i]] up to neighbours[offsets[i + 1]], with the edge lengths at the same indices in weights 
+	struct Graph {
+		std::vector<int> offsets;
+		std::vector<int> neighbours;
+		std::vector<float> weights;
+
+		// node positions as of the last Remake(), structure-of-arrays 
+		std::vector<float> xs;
+		std::vector<float> ys;
+
+		int NodeCount() const { return (int)xs.size(); }
+		int EdgeCount() const { return (int)neighbours.size() / 2; } // every edge is stored once per end 
+		int Begin(int id) const { return offsets[id]; }
+		int End(int id) const { return offsets[id + 1]; }
+		sf::Vector2f Position(int id) const { return sf::Vector2f(xs[id], ys[id]); }
+	};
+
+	// Non-owning handle to one node of the graph, for A* and the Interface; it copies nothing and stays valid until the next Remake() 
+	struct NodeView {
+
+		struct Neighbour {
+			int ID;
+			float weight; // the edge length 
+		};
+
+		// walks the node's CSR row, pairing neighbour ids with edge weights 
+		struct NeighbourIterator {
+			const int* id;
+			const float* weight;
+
+			Neighbour operator*() const { return { *id, *weight }; }
+			NeighbourIterator& operator++() { ++id; ++weight; return *this; }
+			bool operator!=(const NeighbourIterator& other) const { return id != other.id; }
+		};
+
+		struct NeighbourRange {
+			NeighbourIterator first;
+			NeighbourIterator last;
+
+			NeighbourIterator begin() const { return first; }
+			NeighbourIterator end() const { return last; }
+		};
+
+		const Graph* graph;
+		int ID;
+
+		NodeView(const Graph& g, int id) : graph(&g), ID(id) {}
+
+		sf::Vector2f Position() const { return graph->Position(ID); }
+		int Degree() const { return graph->End(ID) - graph->Begin(ID); }
+
+		NeighbourRange Neighbours() const {
+			const int* ids = graph->neighbours.data();
+			const float* weights = graph->weights.data();
+			return { { ids + graph->Begin(ID), weights + graph->Begin(ID) }, { ids + graph->End(ID), weights + graph->End(ID) } };
+		}
+	};
+
+	// Uniform grid over the node positions, about two nodes per cell, for finding nodes by position rather than by id; rebuilt by every 
+	// Remake() and patched by MoveNode(). The cells chain their nodes through next, so that moving a node only relinks it. Positions are not 
+	// copied: the queries read them from the graph the grid was built over 
+	struct NodeGrid {
+		float min_x = 0.0f;
+		float min_y = 0.0f;
+		float max_x = 0.0f;
+		float max_y = 0.0f;
+		float cell_w = 1.0f;
+		float cell_h = 1.0f;
+		int cols = 0;
+		int rows = 0;
+		std::vector<int> head; // first node of every cell, -1 if empty 
+		std::vector<int> next; // per node, the next node of its cell 
+		std::vector<int> cell; // per node, the cell it is chained into 
+
+		// over the bounding box of the graph's nodes 
+		void Build(const Graph& graph);
+		// re-files a node after its position in graph changed; rebuilds the grid if it left the bounding box 
+		void Move(const Graph& graph, int id);
+
+		// the node nearest to pt, -1 if there is none within max_dist 
+		int Nearest(const Graph& graph, sf::Vector2f pt, float max_dist) const;
+		// the k nodes nearest to pt, nearest first (fewer if the graph has fewer) 
+		std::vector<int> KNearest(const Graph& graph, sf::Vector2f pt, int k) const;
+		// every node within radius of pt, in no particular order 
+		std::vector<int> Within(const Graph& graph, sf::Vector2f pt, float radius) const;
+
+		// clamped in floating point, so that far away coordinates do not overflow the conversion 
+		int Col(float x) const { return (int)std::min((float)(cols - 1), std::max(0.0f, (x - min_x) / cell_w)); }
+		int Row(float y) const { return (int)std::min((float)(rows - 1), std::max(0.0f, (y - min_y) / cell_h)); }
+		size_t GetMemoryUsage() const { return sizeof(int) * (head.size() + next.size() + cell.size()); }
+
+	private:
+		// a lower bound on the distance from pt (inside the bounding box, in cell col, row) to the nodes outside the cells within ring - 1 of it 
+		float RingBound(sf::Vector2f pt, int col, int row, int ring) const;
+		// calls visit(id) on every node of the cells at Chebyshev distance ring from cell col, row 
+		template <typename Visit>
+		void VisitRing(int col, int row, int ring, Visit visit) const;
+	};
+
 private:
 
 	struct Node {
 	private:
 		sf::Vector2f position; 
-		std::unordered_map<int, float> neighbours;
 	public:
 		Node(sf::Vector2f pos) : position(pos) {}
 
 		sf::Vector2f GetPosition() const { return position; }
 		void SetPosition(sf::Vector2f pos) { position = pos; }
-
-		const std::unordered_map<int, float>& GetNeighbours() const { return neighbours; }
-		void AddNeighbour(float dist, int id) { neighbours[id] = dist; }
-		void ClearNeighbours() { neighbours.clear(); }
 	};
 
 	// to be set by the user 
@@ -26,34 +167,143 @@ private:
 	int destination_id;
 
 	std::vector<Node> nodes;
-	std::unordered_map<long long int, std::pair<int, int>> edges; 
+	Graph graph;
+
+	BuildTimings timings;
+
+	// kept across Remake() calls, so that rebuilding the mesh (e.g. while dragging a node) reuses the triangulator's scratch memory 
+	struct ScratchArena* scratch = nullptr;
+	size_t scratch_peak = 0;
+
+	// threads for the triangulation, 0 for the hardware concurrency; each strip of a parallel build keeps its own scratch arena 
+	unsigned int build_threads = 1;
+	std::vector<struct ScratchArena*> strip_scratch;
+
+	// insert the nodes in Hilbert-sorted randomized rounds (BRIO) rather than by id; both yield the same triangulation 
+	bool brio_order = true;
+
+	// the Delaunay triangulation behind graph, kept so that MoveNode() only re-triangulates around the moved node 
+	struct Triangulation* triangulation = nullptr;
+
+	// what ReportTriangulation() has passed on to the metrics already, of the totals that are not reset after a report 
+	long long reported_walk_steps = 0;
+	long long reported_arena_allocs = 0;
 
-	// To validate randomly generated nodes 
-	bool InsideObstacles(sf::Vector2f pt, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles);
-	bool RectContains(sf::Vector2f pt, const std::pair<sf::Vector2f, sf::Vector2f>& rect_data, float offset);
+	// the mesh area of the last Remake(), as Bowyer-Watson takes it, and a grid over its obstacles for sampling and edge filtering 
+	sf::Vector2f excircle_centre;
+	float excircle_rad = 0.0f;
+	struct ObstacleGrid* obstacle_grid = nullptr;
+
+	// the area and obstacles of the last Remake(), as given, for snapshots 
+	int width = 0;
+	int height = 0;
+	std::vector<std::pair<sf::Vector2f, sf::Vector2f>> obstacle_rects;
+
+	EdgeChanges edge_changes;
+
+	// raised by every change to the graph, unique across meshes; the version of the last Rebuild(), and per node, the last version that 
+	// changed one of its edges 
+	unsigned int version = 0;
+	unsigned int rebuild_version = 0;
+	std::vector<unsigned int> node_versions;
+
+	NodeGrid node_grid;
+
+	LandmarkTable landmarks;
+	int landmark_count = 0; // as last asked of BuildLandmarks() 
+
+	// MoveNode() working buffers, kept for their capacity 
+	std::vector<int> touched;
+	std::vector<int> touched_row; // per node, -1 unless touched 
+	std::vector<int> link;
+	std::vector<std::pair<int, float>> rows;
+	std::vector<int> row_offsets;
+	Graph spare;
+
+	// converts the obstacles to Bowyer-Watson's Rect struct and builds the obstacle grid over them 
+	void SetObstacles(int sc_w, int sc_h, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles);
 
 	// clear edges ahead of Remake() 
 	void Clear();
 
-public:
+	// triangulate the nodes from scratch, filter the edges against the obstacle grid and rebuild graph 
+	void Rebuild();
 
-	// a struct for sending Node data to other classes, mainly for A*::Node construction and edge display in Interface 
-	struct NodeData {
-		const sf::Vector2f position;
-		const std::unordered_map<int, float> neighbours;
-		const int ID; // for A* to know whether it found the destination 
+	// triangulates the nodes in strip_count vertical strips at once and merges them along their seams into triangulation; returns false if 
+	// the strips could not be merged into exactly the serial result (e.g. cocircular or coincident nodes), and the serial build has to run 
+	bool BuildParallel(int strip_count);
 
-		NodeData(const Node& node, int id) : position(node.GetPosition()), neighbours(node.GetNeighbours()), ID(id) {}
-	};
+	// passes the triangulation's insertion counters and the scratch arenas' heap allocations since the last report on to the metrics 
+	void ReportTriangulation();
+
+	// whether the edge between two nodes stays clear of the obstacles, evaluated the same way whichever end it is asked from 
+	bool EdgeValid(int a, int b) const;
+
+	// loads the triangulation neighbours of a node into link, returns their number 
+	int LoadLink(int id);
+
+	// compact Bowyer-Watson's edge array (terminated by the sentinel edge) into graph; a null array leaves every node without neighbours 
+	void BuildGraph(const struct Edge* triangulation);
+
+public:
 
 	NavMesh(int sc_w, int sc_h, const int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles);
+	// seeded variant, for reproducible meshes in the benchmark; with min_spacing > 0, the nodes are sampled as blue noise, no two closer than 
+	// it, and fewer than pt_count of them are placed if they do not fit 
+	NavMesh(int sc_w, int sc_h, const int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles, unsigned int seed, unsigned int threads = 1, float min_spacing = 0.0f);
+	// loads a mesh from an open snapshot without sampling or triangulating: the graph is copied out of it as it is. The triangulation is not 
+	// stored, so the first MoveNode() rebuilds the mesh from scratch; a snapshot whose adjacency is broken is re-triangulated from its nodes 
+	explicit NavMesh(const MeshSnapshot& snapshot, unsigned int threads = 1);
+	~NavMesh();
+
+	NavMesh(const NavMesh&) = delete;
+	NavMesh& operator=(const NavMesh&) = delete;
 
 	// calls Watson's algorithm - called in NavMesh constructor, and by the Interface in case of node-dragging modifications
 	void Remake(int sc_w, int sc_h, const int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles);
 
+	// moves a node and patches the mesh locally: the node is taken out of the triangulation and inserted at pos, and only the edges around 
+	// its old and new positions are re-checked against the obstacles; the edges it changed are then available from GetEdgeChanges() 
+	// returns false if the mesh had to be rebuilt from scratch instead, in which case the changes are not recorded 
+	bool MoveNode(int id, sf::Vector2f pos);
+	const EdgeChanges& GetEdgeChanges() const { return edge_changes; }
+
+	// the graph's version, raised by every Remake() and MoveNode(), for caches of search results: a result of version v still holds if the 
+	// mesh was not rebuilt since (GetRebuildVersion() <= v) and none of its nodes had an edge taken out, put in or reweighted (GetNodeVersion() <= v) 
+	unsigned int GetVersion() const { return version; }
+	unsigned int GetRebuildVersion() const { return rebuild_version; }
+	unsigned int GetNodeVersion(int id) const { return node_versions[id]; }
+
+	// writes the graph, obstacles and start / destination to path in MeshSnapshot's format; false if the file could not be written 
+	bool Save(const std::string& path) const;
+
+	// threads for the triangulation of the next Remake(), 0 for the hardware concurrency; 1, the default, triangulates serially, as do small 
+	// meshes regardless. Every thread count yields the same edges 
+	void SetBuildThreads(unsigned int threads) { build_threads = threads; }
+	unsigned int GetBuildThreads() const { return build_threads; }
+
+	// whether the next Remake() inserts the nodes in spatially coherent order (the default) or by id; the edges are the same either way, 
+	// only the build time differs 
+	void SetBrioOrder(bool brio) { brio_order = brio; }
+	bool GetBrioOrder() const { return brio_order; }
+
+	// picks count landmarks, each the node farthest along the mesh from those picked before it, and tabulates their distances to every node 
+	// Remake() repeats it with the same count; MoveNode() drops the tables, leaving A_Star::Landmarks() to straight-line distances until then 
+	void BuildLandmarks(int count);
+	const LandmarkTable& GetLandmarks() const { return landmarks; }
+
+	// nodes by position, for snapping world coordinates to the mesh and for hit-testing in the Interface; see NodeGrid 
+	int FindNearest(sf::Vector2f pt, float max_dist = std::numeric_limits<float>::infinity()) const { return node_grid.Nearest(graph, pt, max_dist); }
+	std::vector<int> FindKNearest(sf::Vector2f pt, int k) const { return node_grid.KNearest(graph, pt, k); }
+	std::vector<int> FindWithin(sf::Vector2f pt, float radius) const { return node_grid.Within(graph, pt, radius); }
+	const NodeGrid& GetNodeGrid() const { return node_grid; }
+
 	// getters and setters used by Interface 
 	std::vector<Node>& GetNodes() { return nodes; }
-	const std::unordered_map<long long int, std::pair<int, int>>& GetEdges() { return edges; }
+	const Graph& GetGraph() const { return graph; }
+	const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& GetObstacles() const { return obstacle_rects; }
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
 
 	void SetEntryPoint(int id) { entry_point_id = id; }
 	void SetDestination(int id) { destination_id = id; }
@@ -62,12 +312,16 @@ public:
 	bool EndSelected() { return destination_id != -1; }
 
 	// getters used by A* 
-	NodeData GetEntryPointData() const { return NodeData(nodes[entry_point_id], entry_point_id); }
-	NodeData GetNodeData(int id) const { return NodeData(nodes[id], id); }
+	NodeView GetNode(int id) const { return NodeView(graph, id); }
 
 	int GetEntryPointID() const { return entry_point_id; }
 	int GetDestinationID() const { return destination_id; }
 
+	const BuildTimings& GetBuildTimings() const { return timings; }
+
+	// the most scratch memory the last Remake() had in use at once, in bytes 
+	size_t GetScratchPeak() const { return scratch_peak; }
+
 	// Start/end random selection in case the user does not define them 
 	void RandomStart();
 	void RandomEnd();
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "AStar.h"
+
+
+// Bounded least-recently-used cache of A* results, for agents that ask for the same (start, destination) pairs over and over 
+// the entries are tied to the mesh's version: a Remake() drops them all, while a MoveNode() only drops those whose path runs through a node 
+// whose edges it changed (and those that found no path, which a new edge may have opened). The paths kept stay walkable, but one that a moved 
+// node shortcuts elsewhere is no longer the shortest; Clear() the cache when that matters. Not thread-safe: use one cache per thread 
+class PathCache {
+
+public:
+
+	struct Stats {
+		long long hits = 0;
+		long long misses = 0;
+		long long evictions = 0; // entries dropped for room 
+		long long invalidations = 0; // entries dropped because the mesh changed under them 
+	};
+
+private:
+
+	struct Entry {
+		unsigned long long key; // start in the high half, destination in the low half 
+		std::vector<int> path;
+		int prev = -1; // neighbours in recency order, towards the most and the least recently used entry 
+		int next = -1;
+	};
+
+	size_t capacity;
+	std::vector<Entry> entries;
+	std::unordered_map<unsigned long long, int> index; // key to slot in entries 
+	int head = -1; // the most recently used entry 
+	int tail = -1; // the least recently used entry 
+
+	// the mesh and version the entries are valid for 
+	const NavMesh* synced_mesh = nullptr;
+	unsigned int version = 0;
+
+	Stats stats;
+
+	static unsigned long long Key(int start_id, int destination_id) { return ((unsigned long long)(unsigned int)start_id << 32) | (unsigned int)destination_id; }
+
+	void Unlink(int slot);
+	void PushFront(int slot);
+
+	// drops the entries the mesh's changes since version may have broken 
+	void Sync(const NavMesh& mesh);
+
+public:
+
+	explicit PathCache(size_t capacity = 1024) : capacity(capacity) {}
+
+	// the path between two nodes as A_Star::Find() returns it; from the cache if it holds the pair, without searching (and without touching 
+	// context's stats), and otherwise searched with context and stored, evicting the least recently used entry if the cache is full 
+	std::vector<int> Find(const NavMesh& mesh, int start_id, int destination_id, A_Star::SearchContext& context);
+
+	// empties the cache; the counters are kept 
+	void Clear();
+
+	size_t GetSize() const { return index.size(); }
+	size_t GetCapacity() const { return capacity; }
+	const Stats& GetStats() const { return stats; }
+
+};
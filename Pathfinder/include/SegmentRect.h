@@ -0,0 +1,120 @@
+#pragma once
+
+// Segment vs axis-aligned rectangle intersection kernel, used to filter mesh edges against the obstacles
+// the rectangles are passed as structure-of-arrays centres (cx, cy) and half extents (hx, hy); a segment hits a rectangle (boundary or
+// interior) if their bounding boxes overlap on both axes and the rectangle does not lie wholly on one side of the segment's line
+// everything is multiplies, adds and compares, with no division or branch per rectangle, so the SSE and AVX2 paths test 4 / 8 rectangles at once
+// the widest path the compiler targets is used (e.g. /arch:AVX2 or -mavx2); define SEGMENT_RECT_SCALAR to force the scalar one
+// written in plain C, as it is included by Bowyer-Watson.c
+
+#include <math.h>
+
+#if !defined(SEGMENT_RECT_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SEGMENT_RECT_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if !defined(SEGMENT_RECT_SCALAR) && defined(__AVX2__)
+#define SEGMENT_RECT_AVX2 1
+#include <immintrin.h>
+#endif
+
+// the per-segment terms of the test
+struct SegmentTerms {
+	float x0, y0; // start
+	float dx, dy; // end - start
+	float mx, my; // midpoint
+	float ex, ey; // half extents
+	float adx, ady; // |dx|, |dy|
+};
+
+static inline struct SegmentTerms GetSegmentTerms(float x0, float y0, float x1, float y1) {
+	struct SegmentTerms s;
+	s.x0 = x0;
+	s.y0 = y0;
+	s.dx = x1 - x0;
+	s.dy = y1 - y0;
+	s.mx = (x0 + x1) * 0.5f;
+	s.my = (y0 + y1) * 0.5f;
+	s.adx = fabsf(s.dx);
+	s.ady = fabsf(s.dy);
+	s.ex = s.adx * 0.5f;
+	s.ey = s.ady * 0.5f;
+	return s;
+}
+
+// returns 1 if the segment hits any of the rectangles from begin to end - 1
+static inline int SegmentHitsRectsScalar(struct SegmentTerms s, const float* cx, const float* cy, const float* hx, const float* hy, int begin, int end) {
+	for (int i = begin; i < end; ++i) {
+		int hit = (fabsf(cx[i] - s.mx) <= hx[i] + s.ex)
+			& (fabsf(cy[i] - s.my) <= hy[i] + s.ey)
+			& (fabsf(s.dx * (cy[i] - s.y0) - s.dy * (cx[i] - s.x0)) <= s.adx * hy[i] + s.ady * hx[i]);
+		if (hit) return 1;
+	}
+	return 0;
+}
+
+#ifdef SEGMENT_RECT_SSE
+static inline int SegmentHitsRectsSSE(struct SegmentTerms s, const float* cx, const float* cy, const float* hx, const float* hy, int begin, int end) {
+
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 x0 = _mm_set1_ps(s.x0), y0 = _mm_set1_ps(s.y0);
+	const __m128 dx = _mm_set1_ps(s.dx), dy = _mm_set1_ps(s.dy);
+	const __m128 mx = _mm_set1_ps(s.mx), my = _mm_set1_ps(s.my);
+	const __m128 ex = _mm_set1_ps(s.ex), ey = _mm_set1_ps(s.ey);
+	const __m128 adx = _mm_set1_ps(s.adx), ady = _mm_set1_ps(s.ady);
+
+	int i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 rcx = _mm_loadu_ps(cx + i), rcy = _mm_loadu_ps(cy + i);
+		__m128 rhx = _mm_loadu_ps(hx + i), rhy = _mm_loadu_ps(hy + i);
+
+		__m128 hit = _mm_cmple_ps(_mm_and_ps(_mm_sub_ps(rcx, mx), abs_mask), _mm_add_ps(rhx, ex));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_and_ps(_mm_sub_ps(rcy, my), abs_mask), _mm_add_ps(rhy, ey)));
+		__m128 side = _mm_sub_ps(_mm_mul_ps(dx, _mm_sub_ps(rcy, y0)), _mm_mul_ps(dy, _mm_sub_ps(rcx, x0)));
+		__m128 reach = _mm_add_ps(_mm_mul_ps(adx, rhy), _mm_mul_ps(ady, rhx));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_and_ps(side, abs_mask), reach));
+
+		if (_mm_movemask_ps(hit)) return 1;
+	}
+	return SegmentHitsRectsScalar(s, cx, cy, hx, hy, i, end);
+}
+#endif
+
+#ifdef SEGMENT_RECT_AVX2
+static inline int SegmentHitsRectsAVX2(struct SegmentTerms s, const float* cx, const float* cy, const float* hx, const float* hy, int begin, int end) {
+
+	const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const __m256 x0 = _mm256_set1_ps(s.x0), y0 = _mm256_set1_ps(s.y0);
+	const __m256 dx = _mm256_set1_ps(s.dx), dy = _mm256_set1_ps(s.dy);
+	const __m256 mx = _mm256_set1_ps(s.mx), my = _mm256_set1_ps(s.my);
+	const __m256 ex = _mm256_set1_ps(s.ex), ey = _mm256_set1_ps(s.ey);
+	const __m256 adx = _mm256_set1_ps(s.adx), ady = _mm256_set1_ps(s.ady);
+
+	int i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 rcx = _mm256_loadu_ps(cx + i), rcy = _mm256_loadu_ps(cy + i);
+		__m256 rhx = _mm256_loadu_ps(hx + i), rhy = _mm256_loadu_ps(hy + i);
+
+		__m256 hit = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(rcx, mx), abs_mask), _mm256_add_ps(rhx, ex), _CMP_LE_OQ);
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(rcy, my), abs_mask), _mm256_add_ps(rhy, ey), _CMP_LE_OQ));
+		__m256 side = _mm256_sub_ps(_mm256_mul_ps(dx, _mm256_sub_ps(rcy, y0)), _mm256_mul_ps(dy, _mm256_sub_ps(rcx, x0)));
+		__m256 reach = _mm256_add_ps(_mm256_mul_ps(adx, rhy), _mm256_mul_ps(ady, rhx));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_and_ps(side, abs_mask), reach, _CMP_LE_OQ));
+
+		if (_mm256_movemask_ps(hit)) return 1;
+	}
+	return SegmentHitsRectsSSE(s, cx, cy, hx, hy, i, end);
+}
+#endif
+
+// the widest path available
+static inline int SegmentHitsRects(struct SegmentTerms s, const float* cx, const float* cy, const float* hx, const float* hy, int begin, int end) {
+#if defined(SEGMENT_RECT_AVX2)
+	return SegmentHitsRectsAVX2(s, cx, cy, hx, hy, begin, end);
+#elif defined(SEGMENT_RECT_SSE)
+	return SegmentHitsRectsSSE(s, cx, cy, hx, hy, begin, end);
+#else
+	return SegmentHitsRectsScalar(s, cx, cy, hx, hy, begin, end);
+#endif
+}
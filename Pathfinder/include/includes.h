@@ -4,9 +4,15 @@
 
 #include <iostream>
 #include <vector> 
+#include <algorithm> // std::reverse in A*, std::sort in the benchmark 
 #include <unordered_map> // for A* to check if nodes have been visited before or have been enqueued
 #include <tuple> 
 #include <chrono> // for interface cooldown 
 #include <random> // random point seeding for triangulation 
 #include <cmath> // sqrt
+#include <limits> // infinite heuristics, for nodes that cannot reach the destination 
 #include <chrono> // timing the search algorithms 
+#include <thread> // A* batch queries 
+#include <atomic> 
+#include <memory> // the backward half of a bidirectional A* context 
+#include <queue> // k-nearest node queries 
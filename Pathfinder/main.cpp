@@ -23,8 +23,6 @@ int main() {
 
         interface->Update(Window);
 
-        //if (sf::Keyboard::isKeyPressed(sf::Keyboard::BackSpace)) interface->Test(Window);
-
         Window.display();
     }
 
@@ -1,87 +1,288 @@
 #include "AStar.h"
+#include "Metrics.h"
 #include "NavMesh.h"
 
+void A_Star::SearchContext::Reset(int node_count) {
+
+	// the queue still points into the pool, so it is emptied before the pool is cleared or regrown 
+	queue.Clear();
+
+	if (stamps.Resize(node_count)) {
+		state.resize(node_count);
+		g_cost.resize(node_count);
+		parent.resize(node_count);
+		enqueued.resize(node_count);
+		pool.reserve(node_count);
+	}
+	stamps.Next();
+
+	pool.clear();
+	queue.Reserve(node_count);
+	stats = Stats();
+}
+
+A_Star::Node* A_Star::SearchContext::Open(int id, int parent_id, float g, float h) {
+
+	pool.emplace_back(id);
+	Node* node = &pool.back();
+	node->g_cost = g;
+	node->h_cost = h;
+
+	stamps.Mark(id);
+	state[id] = OPEN;
+	g_cost[id] = g;
+	parent[id] = parent_id;
+	enqueued[id] = node;
+
+	queue.Insert(node);
+	++stats.pushed;
+	return node;
+}
+
+float A_Star::Euclidean(const NavMesh& mesh, int id, int destination_id) {
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	float dx = graph.xs[id] - graph.xs[destination_id];
+	float dy = graph.ys[id] - graph.ys[destination_id];
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+float A_Star::Landmarks(const NavMesh& mesh, int id, int destination_id) {
+
+	float h = Euclidean(mesh, id, destination_id);
+
+	// |d(L, destination) - d(L, id)| is a lower bound on d(id, destination) for every landmark L; both rows are count floats in a row 
+	const NavMesh::LandmarkTable& table = mesh.GetLandmarks();
+	if (!table.Valid()) return h;
+	const float* from = table.Row(id);
+	const float* to = table.Row(destination_id);
+	for (int k = 0; k < table.count; ++k) {
+		bool from_reached = from[k] != NavMesh::LandmarkTable::UNREACHABLE, to_reached = to[k] != NavMesh::LandmarkTable::UNREACHABLE;
+		if (from_reached != to_reached) return std::numeric_limits<float>::infinity(); // the two lie in different parts of the mesh 
+		if (from_reached) h = std::max(h, std::fabs(to[k] - from[k]));
+	}
+	return h;
+}
+
 std::vector<int> A_Star::Find(const NavMesh& mesh) {
+	static thread_local SearchContext context;
+	return Find(mesh, context);
+}
+
+std::vector<int> A_Star::Find(const NavMesh& mesh, SearchContext& context) {
+
+	std::vector<int> path = Find(mesh, mesh.GetEntryPointID(), mesh.GetDestinationID(), context);
+	if (path.empty()) METRICS_EVENT("No valid path found");
+	return path;
+}
+
+std::vector<int> A_Star::Find(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context) {
+
+	METRICS_TIMER(SEARCH_US);
+	std::vector<int> path = context.mode == BIDIRECTIONAL ? FindBidirectional(mesh, start_id, destination_id, context) : FindForward(mesh, start_id, destination_id, context);
+
+	// the search counts into its stats, which are reported once per query 
+	METRICS_COUNT(PATHS_FOUND, path.empty() ? 0 : 1);
+	METRICS_COUNT(PATHS_NOT_FOUND, path.empty() ? 1 : 0);
+	METRICS_COUNT(NODES_EXPANDED, context.stats.expanded);
+	METRICS_COUNT(HEAP_PUSHES, context.stats.pushed);
+	METRICS_COUNT(HEAP_DECREASES, context.stats.decreased);
+	return path;
+}
+
+std::vector<int> A_Star::FindForward(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context) {
 
 	std::vector<int> path; // return vector 
-	std::unordered_map<int, Node*> visited; // to keep track of previously visited nodes 
-	std::unordered_map<int, Node*> enqueued; // to keep track of enqueued nodes 
-	std::vector<Node*> memory_vect; // to keep track of any dynamic allocations
 
-	// accepts a lambda to compare nodes in Heap::HeapUp() and Heap::HeapDown();
-	Heap<Node, int> queue = Heap<Node, int>([](Node* n1, Node* n2) {return n1->h_cost + n1->g_cost < n2->h_cost + n2->g_cost;});
+	context.Reset(mesh.GetGraph().NodeCount());
 
-	Node* entry_point = new Node(std::move(mesh.GetEntryPointData()));
-	sf::Vector2f destination_pos = mesh.GetNodeData(mesh.GetDestinationID()).position;
-	queue.Insert(entry_point);
-	memory_vect.push_back(entry_point);
+	Heuristic heuristic = context.heuristic;
+	const float unreachable = std::numeric_limits<float>::infinity();
+	float start_h = heuristic(mesh, start_id, destination_id);
+	if (start_h == unreachable) return path;
+	context.Open(start_id, -1, 0.0f, start_h);
 
 	Node* current = nullptr; 
 
-	auto start = std::chrono::high_resolution_clock::now();
-
 	bool found = false; 
-	while (!queue.Empty()) {
-
-		current = queue.RemoveRoot();
-		visited.insert({ current->data.ID, current });
+	while (!context.queue.Empty()) {
+		current = context.queue.RemoveRoot();
+		context.state[current->ID] = SearchContext::CLOSED;
+		++context.stats.expanded;
 
 		// the algorithm reached its destination 
-		if (current->data.ID == mesh.GetDestinationID()) {
+		if (current->ID == destination_id) {
 			found = true;
 			break;
 		}
 
-		const std::unordered_map<int, float>& neighbours = current->data.neighbours;
-
 		// iterate through the neighbours, set their costs and enqueue them 
-		for (const auto& [id, distance] : neighbours) {
-
-			if (visited.count(id) > 0) continue;
-
-			if (enqueued.count(id) == 0) {
+		for (const NavMesh::NodeView::Neighbour neighbour : mesh.GetNode(current->ID).Neighbours()) {
 
-				Node* next = new Node(mesh.GetNodeData(id));
-				memory_vect.push_back(next);
+			int id = neighbour.ID;
+			float g = current->g_cost + neighbour.weight;
 
-				next->parent = current;
-				next->SetHCost(next->data.position - destination_pos);
-				next->g_cost = current->g_cost + distance;
+			SearchContext::State state = context.GetState(id);
+			if (state == SearchContext::CLOSED) continue;
 
-				queue.Insert(next);
-				enqueued.insert({ id, next });
-			}
-			else {
-				// if the neighbour is already enqueued, and the path from current is shorter, then a better path to this neighbour was found 
-				if (current->g_cost + distance < enqueued.at(id)->g_cost) {
-					Node* n = enqueued.at(id);
-					n->g_cost = current->g_cost + distance;
-					n->parent = current;
+			if (state == SearchContext::UNSEEN) {
+				float h = heuristic(mesh, id, destination_id);
+				if (h != unreachable) context.Open(id, current->ID, g, h);
+				else {
+					context.stamps.Mark(id);
+					context.state[id] = SearchContext::CLOSED;
 				}
-				else continue; 
 			}
 
+			// if the neighbour is already enqueued, and the path from current is shorter, then a better path to this neighbour was found 
+			else if (g < context.g_cost[id]) {
+				Node* n = context.enqueued[id];
+				n->g_cost = g;
+				context.queue.DecreaseKey(n);
+				context.g_cost[id] = g;
+				context.parent[id] = current->ID;
+				++context.stats.decreased;
+			}
 		}
 	}
 
 	// reconstruct the path 
 	if (found) {
-		Node* current_on_path = current;
-		while (current_on_path->parent != nullptr) {
-			path.push_back(current_on_path->data.ID);
-			current_on_path = current_on_path->parent; 
-		}
-		path.push_back(current_on_path->data.ID);
+		for (int id = destination_id; id != -1; id = context.parent[id]) path.push_back(id);
 		std::reverse(path.begin(), path.end());
+		context.stats.cost = current->g_cost;
+	}
+	context.stats.expanded_forward = context.stats.expanded;
 
-		std::cout << "Path found in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << " milliseconds\n\n";
+	return path; 
+}
+
+std::vector<int> A_Star::FindBidirectional(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context) {
+
+	std::vector<int> path;
+
+	int node_count = mesh.GetGraph().NodeCount();
+	context.Reset(node_count);
+	if (!context.backward) context.backward.reset(new SearchContext());
+	SearchContext& backward = *context.backward;
+	backward.Reset(node_count);
+
+	Heuristic heuristic = context.heuristic;
+	const float unreachable = std::numeric_limits<float>::infinity();
+	if (start_id == destination_id) {
+		path.push_back(start_id);
+		return path;
 	}
-	else std::cout << "No valid path found\n";
+	if (heuristic(mesh, start_id, destination_id) == unreachable) return path;
+
+	// the searches are ordered by the average of the two heuristics, half the estimate towards their own goal less half the estimate back 
+	// to their own root: unlike the plain heuristics, these agree on every edge's reduced length, so a node settled by either search has its 
+	// final distance, and no path shorter than the best found so far is left once the two queue tops add up to it 
+	auto potential = [&](int id, bool forward) {
+		float to_destination = heuristic(mesh, id, destination_id), to_start = heuristic(mesh, id, start_id);
+		if (to_destination == unreachable || to_start == unreachable) return unreachable;
+		return forward ? 0.5f * (to_destination - to_start) : 0.5f * (to_start - to_destination);
+	};
+
+	context.Open(start_id, -1, 0.0f, potential(start_id, true));
+	backward.Open(destination_id, -1, 0.0f, potential(destination_id, false));
+
+	float best = unreachable;
+	int meeting = -1;
+	while (true) {
+		Node* forward_top = context.queue.GetRoot();
+		Node* backward_top = backward.queue.GetRoot();
+		float forward_key = forward_top != nullptr ? forward_top->g_cost + forward_top->h_cost : unreachable;
+		float backward_key = backward_top != nullptr ? backward_top->g_cost + backward_top->h_cost : unreachable;
+		if (forward_key + backward_key >= best) break;
+
+		bool forward = forward_key <= backward_key;
+		SearchContext& side = forward ? context : backward;
+		const SearchContext& other = forward ? backward : context;
+
+		Node* current = side.queue.RemoveRoot();
+		side.state[current->ID] = SearchContext::CLOSED;
+		++(forward ? context.stats.expanded_forward : context.stats.expanded_backward);
+
+		for (const NavMesh::NodeView::Neighbour neighbour : mesh.GetNode(current->ID).Neighbours()) {
+
+			int id = neighbour.ID;
+			float g = current->g_cost + neighbour.weight;
+
+			SearchContext::State state = side.GetState(id);
+			if (state == SearchContext::CLOSED) continue;
+
+			if (state == SearchContext::UNSEEN) {
+				float p = potential(id, forward);
+				if (p == unreachable) {
+					side.stamps.Mark(id);
+					side.state[id] = SearchContext::CLOSED;
+					continue;
+				}
+				side.Open(id, current->ID, g, p);
+			}
+			else if (g < side.g_cost[id]) {
+				Node* n = side.enqueued[id];
+				n->g_cost = g;
+				side.queue.DecreaseKey(n);
+				side.g_cost[id] = g;
+				side.parent[id] = current->ID;
+				++context.stats.decreased;
+			}
+			else continue;
 
-	for (auto& node : memory_vect) {
-		if (node != nullptr) delete node; 
-		node = nullptr; 
+			// the node's label improved; through it, the two searches join into a path 
+			if (other.GetState(id) != SearchContext::UNSEEN && g + other.g_cost[id] < best) {
+				best = g + other.g_cost[id];
+				meeting = id;
+			}
+		}
 	}
 
-	return path; 
+	context.stats.expanded = context.stats.expanded_forward + context.stats.expanded_backward;
+	context.stats.pushed += backward.stats.pushed;
+	if (meeting == -1) return path;
+
+	for (int id = meeting; id != -1; id = context.parent[id]) path.push_back(id);
+	std::reverse(path.begin(), path.end());
+	for (int id = backward.parent[meeting]; id != -1; id = backward.parent[id]) path.push_back(id);
+	context.stats.cost = best;
+
+	return path;
+}
+
+std::vector<A_Star::Result> A_Star::FindBatch(const NavMesh& mesh, const Query* queries, size_t count, unsigned int thread_count, Heuristic heuristic) {
+
+	std::vector<Result> results(count);
+
+	if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+	if (thread_count > count) thread_count = (unsigned int)std::max<size_t>(count, 1);
+
+	// workers claim small chunks of queries from a shared counter, which balances long and short searches without a scheduler 
+	const size_t chunk = 16;
+	std::atomic<size_t> next(0);
+
+	auto worker = [&]() {
+		SearchContext context;
+		context.SetHeuristic(heuristic);
+		for (size_t first = next.fetch_add(chunk); first < count; first = next.fetch_add(chunk)) {
+			size_t last = std::min(first + chunk, count);
+			for (size_t i = first; i < last; ++i) {
+				results[i].path = Find(mesh, queries[i].start, queries[i].destination, context);
+				results[i].stats = context.GetStats();
+			}
+		}
+	};
+
+	if (thread_count <= 1) {
+		worker();
+		return results;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(thread_count - 1);
+	for (unsigned int t = 1; t < thread_count; ++t) workers.emplace_back(worker);
+	worker(); // the calling thread works too 
+	for (std::thread& t : workers) t.join();
+
+	return results;
 }
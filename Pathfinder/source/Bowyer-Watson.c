@@ -1,15 +1,11 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
-
-// for defining a key for NavMesh::edges map 
-long long int CantorPair(long long int x, long long int y) {
-	long long int res = (x + y) * (x + y + 1) / 2 + y;
-	return res; 
-}
-
+#include "SegmentRect.h"
 
 
 // each point has an id, making it significantly easier to distinguish them in the course of BowyerWatson(), 
@@ -20,42 +16,10 @@ struct Point {
 	int id;
 };
 
-// used to check whether an intersection point of two lines lies on either of them 
-int Between(struct Point pt, struct Point s, struct Point e) {
-
-	float max_x;
-	float min_x;
-	float max_y;
-	float min_y;
-
-	if (s.x >= e.x) {
-		max_x = s.x;
-		min_x = e.x;
-	}
-	else {
-		max_x = e.x;
-		min_x = s.x;
-	}
-	if (s.y >= e.y) {
-		max_y = s.y;
-		min_y = e.y;
-	}
-	else {
-		max_y = e.y;
-		min_y = s.y;
-	}
-	if ((int)pt.x <= (int)max_x && (int)pt.x >= (int)min_x && (int)pt.y <= (int)max_y && (int)pt.y >= (int)min_y) return 1;
-	else return 0; 
-
-}
-
-
-// for checking edge-edge intersections in edge-obstacle intersection check 
+// an obstacle's side, or a mesh edge to be checked against the obstacles 
 struct ObsEdge {
 	struct Point start;
 	struct Point end; 
-	float slope;
-	float y_intercept;
 };
 
 // Helper struct for managing polygons and triangle edges in determining unique edges and creating new triangles out of them and the next mesh point 
@@ -101,334 +65,1696 @@ struct Rect {
 	struct ObsEdge edges[4];
 };
 
-// helper to IntersectRect()
-int IntersectsEdge(struct ObsEdge edge, struct ObsEdge other) {
+// Uniform grid over the obstacles, so that an edge or a point is only tested against the obstacles around it 
+// every cell lists the obstacles whose bounds overlap it, items[cell_start[c]] up to items[cell_start[c + 1]], together with copies of their 
+// centres and half extents in the same order, which is the layout the SegmentRect.h kernel streams through 
+struct ObstacleGrid {
+	int obs_count;
+	float* bounds; // min x, min y, max x, max y of every obstacle 
 
-	if (fabs(edge.slope - other.slope) < 1e-14) return 0;
+	float min_x;
+	float min_y;
+	float cell_w;
+	float cell_h;
+	int cols;
+	int rows;
+	int* cell_start;
+	int* items;
+	float* item_cx;
+	float* item_cy;
+	float* item_hx;
+	float* item_hy;
+};
 
-	struct Point intersect_pt;
-	if (isinf(other.slope) || other.slope == 0.0f) {
-		if (isinf(other.slope)) {
-			intersect_pt.x = other.start.x;
-			intersect_pt.y = edge.slope * intersect_pt.x + edge.y_intercept;
-		}
-		else {
-			intersect_pt.x = (other.y_intercept - edge.y_intercept) / (edge.slope - other.slope);
-			intersect_pt.y = other.start.y;
+void InitObstacleGrid(struct ObstacleGrid* grid) {
+	grid->obs_count = 0;
+	grid->bounds = NULL;
+	grid->cols = 0;
+	grid->rows = 0;
+	grid->cell_start = NULL;
+	grid->items = NULL;
+	grid->item_cx = NULL;
+	grid->item_cy = NULL;
+	grid->item_hx = NULL;
+	grid->item_hy = NULL;
+}
+
+void FreeObstacleGrid(struct ObstacleGrid* grid) {
+	free(grid->bounds);
+	free(grid->cell_start);
+	free(grid->items);
+	free(grid->item_cx);
+	free(grid->item_cy);
+	free(grid->item_hx);
+	free(grid->item_hy);
+	InitObstacleGrid(grid);
+}
+
+// the range of cells overlapped by the box, clamped to the grid; returns 0 if the box misses the grid altogether 
+int GridRange(const struct ObstacleGrid* grid, float min_x, float min_y, float max_x, float max_y, int* c0, int* r0, int* c1, int* r1) {
+
+	float x0 = (min_x - grid->min_x) / grid->cell_w;
+	float y0 = (min_y - grid->min_y) / grid->cell_h;
+	float x1 = (max_x - grid->min_x) / grid->cell_w;
+	float y1 = (max_y - grid->min_y) / grid->cell_h;
+	if (x1 < 0 || y1 < 0 || x0 >= grid->cols || y0 >= grid->rows) return 0;
+
+	*c0 = x0 < 0 ? 0 : (int)x0;
+	*r0 = y0 < 0 ? 0 : (int)y0;
+	*c1 = x1 >= grid->cols ? grid->cols - 1 : (int)x1;
+	*r1 = y1 >= grid->rows ? grid->rows - 1 : (int)y1;
+	return 1;
+}
+
+// (re)builds the grid over obstacles; about one cell per obstacle, over the obstacles' extent 
+// returns 0 if memory ran out, leaving the grid empty; the caller reports it 
+int BuildObstacleGrid(struct ObstacleGrid* grid, struct Rect* obstacles, int obs_count) {
+
+	FreeObstacleGrid(grid);
+
+	grid->obs_count = obs_count;
+	if (obs_count == 0) return 1;
+
+	grid->bounds = (float*)malloc(sizeof(float) * 4 * obs_count);
+	if (grid->bounds == NULL) {
+		FreeObstacleGrid(grid);
+		return 0;
+	}
+
+	float ext_min_x = 0, ext_min_y = 0, ext_max_x = 0, ext_max_y = 0;
+	for (int i = 0; i < obs_count; ++i) {
+
+		float* b = grid->bounds + 4 * i;
+		b[0] = b[2] = obstacles[i].edges[0].start.x;
+		b[1] = b[3] = obstacles[i].edges[0].start.y;
+		for (int j = 0; j < 4; ++j) {
+			struct Point corner = obstacles[i].edges[j].end;
+			b[0] = fminf(b[0], corner.x);
+			b[1] = fminf(b[1], corner.y);
+			b[2] = fmaxf(b[2], corner.x);
+			b[3] = fmaxf(b[3], corner.y);
 		}
+
+		if (i == 0 || b[0] < ext_min_x) ext_min_x = b[0];
+		if (i == 0 || b[1] < ext_min_y) ext_min_y = b[1];
+		if (i == 0 || b[2] > ext_max_x) ext_max_x = b[2];
+		if (i == 0 || b[3] > ext_max_y) ext_max_y = b[3];
 	}
 
-	else if (isinf(edge.slope) || edge.slope == 0.0f) {
-		if (isinf(edge.slope)) {
-			intersect_pt.x = edge.start.x;
-			intersect_pt.y = edge.slope * intersect_pt.x + edge.y_intercept;
+	int side = (int)ceil(sqrt((double)obs_count));
+	grid->cols = side;
+	grid->rows = side;
+	grid->min_x = ext_min_x;
+	grid->min_y = ext_min_y;
+	grid->cell_w = (ext_max_x - ext_min_x) / side + 1e-3f;
+	grid->cell_h = (ext_max_y - ext_min_y) / side + 1e-3f;
+
+	// count the obstacles per cell, turn the counts into offsets, then fill the cells 
+	grid->cell_start = (int*)calloc(side * side + 1, sizeof(int));
+	if (grid->cell_start == NULL) {
+		FreeObstacleGrid(grid);
+		return 0;
+	}
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int i = 0; i < obs_count; ++i) {
+
+			const float* b = grid->bounds + 4 * i;
+			int c0, r0, c1, r1;
+			GridRange(grid, b[0], b[1], b[2], b[3], &c0, &r0, &c1, &r1);
+			for (int r = r0; r <= r1; ++r) {
+				for (int c = c0; c <= c1; ++c) {
+					if (pass == 0) {
+						++grid->cell_start[r * side + c + 1];
+						continue;
+					}
+					int k = grid->cell_start[r * side + c]++;
+					grid->items[k] = i;
+					grid->item_cx[k] = (b[0] + b[2]) * 0.5f;
+					grid->item_cy[k] = (b[1] + b[3]) * 0.5f;
+					grid->item_hx[k] = (b[2] - b[0]) * 0.5f;
+					grid->item_hy[k] = (b[3] - b[1]) * 0.5f;
+				}
+			}
 		}
-		else {
-			intersect_pt.x = (edge.y_intercept - other.y_intercept) / (other.slope - edge.slope);
-			intersect_pt.y = edge.start.y;
+
+		if (pass == 0) {
+			for (int c = 0; c < side * side; ++c) grid->cell_start[c + 1] += grid->cell_start[c];
+			int item_count = grid->cell_start[side * side] + 1;
+			grid->items = (int*)malloc(sizeof(int) * item_count);
+			grid->item_cx = (float*)malloc(sizeof(float) * item_count);
+			grid->item_cy = (float*)malloc(sizeof(float) * item_count);
+			grid->item_hx = (float*)malloc(sizeof(float) * item_count);
+			grid->item_hy = (float*)malloc(sizeof(float) * item_count);
+			if (grid->items == NULL || grid->item_cx == NULL || grid->item_cy == NULL || grid->item_hx == NULL || grid->item_hy == NULL) {
+						FreeObstacleGrid(grid);
+				return 0;
+			}
 		}
 	}
-	else {
-		intersect_pt.x = (other.y_intercept - edge.y_intercept) / (edge.slope - other.slope);
-		intersect_pt.y = edge.slope * intersect_pt.x + edge.y_intercept;
+
+	// filling advanced every cell's start to the next cell's, so shift them back 
+	for (int c = side * side; c > 0; --c) grid->cell_start[c] = grid->cell_start[c - 1];
+	grid->cell_start[0] = 0;
+
+	return 1;
+}
+
+// returns 1 if the edge stays clear of every obstacle, 0 if it touches or crosses one 
+// an obstacle spanning several of the edge's cells is tested once per cell, which is cheaper than remembering which ones were tested 
+int GridObstacleCheck(const struct ObstacleGrid* grid, struct ObsEdge edge) {
+
+	if (grid->obs_count == 0) return 1;
+
+	int c0, r0, c1, r1;
+	if (!GridRange(grid, fminf(edge.start.x, edge.end.x), fminf(edge.start.y, edge.end.y), fmaxf(edge.start.x, edge.end.x), fmaxf(edge.start.y, edge.end.y), &c0, &r0, &c1, &r1)) return 1;
+
+	struct SegmentTerms terms = GetSegmentTerms(edge.start.x, edge.start.y, edge.end.x, edge.end.y);
+	for (int r = r0; r <= r1; ++r) {
+		for (int c = c0; c <= c1; ++c) {
+			int cell = r * grid->cols + c;
+			if (SegmentHitsRects(terms, grid->item_cx, grid->item_cy, grid->item_hx, grid->item_hy, grid->cell_start[cell], grid->cell_start[cell + 1])) return 0;
+		}
 	}
+	return 1;
+}
 
-	if (Between(intersect_pt, edge.start, edge.end) && Between(intersect_pt, other.start, other.end)) return 1;
-	else return 0; 
+// returns 1 if pt lies within offset of an obstacle 
+int GridObstacleContains(const struct ObstacleGrid* grid, struct Point pt, float offset) {
+
+	if (grid->obs_count == 0) return 0;
+
+	int c0, r0, c1, r1;
+	if (!GridRange(grid, pt.x - offset, pt.y - offset, pt.x + offset, pt.y + offset, &c0, &r0, &c1, &r1)) return 0;
+
+	for (int r = r0; r <= r1; ++r) {
+		for (int c = c0; c <= c1; ++c) {
+			for (int k = grid->cell_start[r * grid->cols + c]; k < grid->cell_start[r * grid->cols + c + 1]; ++k) {
+				const float* b = grid->bounds + 4 * grid->items[k];
+				if (pt.x >= b[0] - offset && pt.x <= b[2] + offset && pt.y >= b[1] - offset && pt.y <= b[3] + offset) return 1;
+			}
+		}
+	}
+	return 0;
 }
 
-// helper to ObstacleCheck()
-int IntersectsRect(struct ObsEdge edge, struct Rect obs) {
 
-	edge.slope = (edge.end.y - edge.start.y) / (edge.end.x - edge.start.x);
-	edge.y_intercept = edge.start.y - edge.slope * edge.start.x;
 
-	for (int i = 0; i < 4; ++i) if (IntersectsEdge(edge, obs.edges[i])) return 1;
+// Geometric predicates 
+// Orient() and InCircle() are determinants whose sign is always exact: the determinant is first evaluated in double and returned if it exceeds 
+// a bound on its rounding error (Shewchuk's stage A filters); otherwise it is recomputed exactly as an expansion - a sum of non-overlapping 
+// doubles in increasing order of magnitude, whose last component carries the sign. Only near-collinear or near-cocircular inputs reach that path 
+#define PRED_EPSILON 1.1102230246251565e-16 // 2^-53 
+#define ORIENT_BOUND ((3.0 + 16.0 * PRED_EPSILON) * PRED_EPSILON)
+#define INCIRCLE_BOUND ((10.0 + 96.0 * PRED_EPSILON) * PRED_EPSILON)
 
-	return 0; 
+// a + b = *sum + *err exactly 
+void TwoSum(double a, double b, double* sum, double* err) {
+	double s = a + b;
+	double b_virt = s - a;
+	double a_virt = s - b_virt;
+	*sum = s;
+	*err = (a - a_virt) + (b - b_virt);
 }
 
-int ObstacleCheck(struct ObsEdge edge, struct Rect* obstacles, int obs_size) {
-	for (int i = 0; i < obs_size; ++i) {
-		if (IntersectsRect(edge, obstacles[i])) return 0;
+// a * b = *product + *err exactly; fma() rounds only once, so it recovers the product's rounding error 
+void TwoProduct(double a, double b, double* product, double* err) {
+	double p = a * b;
+	*product = p;
+	*err = fma(a, b, -p);
+}
+
+// writes a - b to h (2 components at most), returns the length 
+int DiffExpansion(double a, double b, double* h) {
+	double diff, err;
+	TwoSum(a, -b, &diff, &err);
+	int len = 0;
+	if (err != 0.0) h[len++] = err;
+	h[len++] = diff;
+	return len;
+}
+
+// h = e + f, zero components dropped; h needs room for elen + flen components, returns its length 
+int ExpansionSum(int elen, const double* e, int flen, const double* f, double* h) {
+
+	// merge both expansions by magnitude, then accumulate from the smallest component up 
+	int i = 0, j = 0, hlen = 0;
+	double q = (flen == 0 || (elen > 0 && fabs(e[0]) < fabs(f[0]))) ? e[i++] : f[j++];
+	while (i < elen || j < flen) {
+		double next = (j == flen || (i < elen && fabs(e[i]) < fabs(f[j]))) ? e[i++] : f[j++];
+		double err;
+		TwoSum(q, next, &q, &err);
+		if (err != 0.0) h[hlen++] = err;
 	}
-	return 1; 
+	if (q != 0.0 || hlen == 0) h[hlen++] = q;
+	return hlen;
 }
 
-// generate slopes and y intercepts for all obstacle edges; called at the beginning of BowyerWatson() 
-void GenObstacleEdges(struct Rect* obstacles, int obs_size) {
-	for (int i = 0; i < obs_size; ++i) {
-		for (int j = 0; j < 4; ++j) {
-			obstacles[i].edges[j].slope = (obstacles[i].edges[j].end.y - obstacles[i].edges[j].start.y) / (obstacles[i].edges[j].end.x - obstacles[i].edges[j].start.x);
-			obstacles[i].edges[j].y_intercept = obstacles[i].edges[j].start.y - obstacles[i].edges[j].slope * obstacles[i].edges[j].start.x;
-		}
+// h = e * b, zero components dropped; h needs room for 2 * elen components, returns its length 
+int ScaleExpansion(int elen, const double* e, double b, double* h) {
+
+	int hlen = 0;
+	double q, err;
+	TwoProduct(e[0], b, &q, &err);
+	if (err != 0.0) h[hlen++] = err;
+
+	for (int i = 1; i < elen; ++i) {
+		double product, product_err, sum;
+		TwoProduct(e[i], b, &product, &product_err);
+		TwoSum(q, product_err, &sum, &err);
+		if (err != 0.0) h[hlen++] = err;
+		TwoSum(product, sum, &q, &err);
+		if (err != 0.0) h[hlen++] = err;
 	}
+	if (q != 0.0 || hlen == 0) h[hlen++] = q;
+	return hlen;
 }
 
+// h = e * f, the sum of e scaled by each component of f; h needs room for 2 * elen * flen components, tmp for twice that plus 2 * elen 
+int ExpansionProduct(int elen, const double* e, int flen, const double* f, double* h, double* tmp) {
 
+	double* acc = tmp;
+	double* next = tmp + 2 * elen * flen;
+	double* scaled = next + 2 * elen * flen;
 
-// Circumcircle struct and methods 
-struct Circumcircle {
-	float radius;
-	float centre_x;
-	float centre_y;
-};
+	int acc_len = ScaleExpansion(elen, e, f[0], acc);
+	for (int k = 1; k < flen; ++k) {
+		int scaled_len = ScaleExpansion(elen, e, f[k], scaled);
+		int next_len = ExpansionSum(acc_len, acc, scaled_len, scaled, next);
+
+		double* swap = acc;
+		acc = next;
+		next = swap;
+		acc_len = next_len;
+	}
+	memcpy(h, acc, sizeof(double) * acc_len);
+	return acc_len;
+}
 
-int CircumcircleContains(struct Point pt, struct Circumcircle circumcircle) {
+void NegateExpansion(int elen, double* e) {
+	for (int i = 0; i < elen; ++i) e[i] = -e[i];
+}
 
-	struct Point to_centre;
-	to_centre.x = pt.x - circumcircle.centre_x;
-	to_centre.y = pt.y - circumcircle.centre_y;
+double OrientExact(struct Point a, struct Point b, struct Point c) {
 
-	float len = (float)sqrt(to_centre.x * to_centre.x + to_centre.y * to_centre.y);
+	double bax[2], bay[2], cax[2], cay[2];
+	int bax_len = DiffExpansion(b.x, a.x, bax);
+	int bay_len = DiffExpansion(b.y, a.y, bay);
+	int cax_len = DiffExpansion(c.x, a.x, cax);
+	int cay_len = DiffExpansion(c.y, a.y, cay);
 
-	if (len < circumcircle.radius) return 1;
-	else return 0;
+	double left[8], right[8], det[16], tmp[24];
+	int left_len = ExpansionProduct(bax_len, bax, cay_len, cay, left, tmp);
+	int right_len = ExpansionProduct(bay_len, bay, cax_len, cax, right, tmp);
+	NegateExpansion(right_len, right);
+	int det_len = ExpansionSum(left_len, left, right_len, right, det);
+
+	return det[det_len - 1];
 }
 
+// orientation of (a, b, c): the sign tells on which side of the line a->b the point c lies, 0 if collinear 
+double Orient(struct Point a, struct Point b, struct Point c) {
 
+	double left = ((double)b.x - a.x) * ((double)c.y - a.y);
+	double right = ((double)b.y - a.y) * ((double)c.x - a.x);
+	double det = left - right;
 
-// Triangle struct and methods 
-// vertices defined counterclockwise 
-struct Triangle {
-	struct Point vertices[3];
-	struct PolyEdge edges[3];
-	struct Circumcircle circumcircle;
-};
+	double bound = ORIENT_BOUND * (fabs(left) + fabs(right));
+	if (det > bound || -det > bound) return det;
+	return OrientExact(a, b, c);
+}
 
-struct Circumcircle GetCircumcircle(struct Triangle triangle) {
+// one term of the exact in-circle determinant, (px^2 + py^2) * (qx * ry - qy * rx); every input has at most 2 components, so h needs 512 
+int InCircleTerm(const double* px, int px_len, const double* py, int py_len, const double* qx, int qx_len, const double* qy, int qy_len,
+	const double* rx, int rx_len, const double* ry, int ry_len, double* h) {
 
-	struct Circumcircle res;
+	double tmp[1056];
+	double sq_x[8], sq_y[8], lift[16], cross_l[8], cross_r[8], cross[16];
 
-	struct Point A = triangle.vertices[0];
-	struct Point B = triangle.vertices[1];
-	struct Point C = triangle.vertices[2];
+	int sq_x_len = ExpansionProduct(px_len, px, px_len, px, sq_x, tmp);
+	int sq_y_len = ExpansionProduct(py_len, py, py_len, py, sq_y, tmp);
+	int lift_len = ExpansionSum(sq_x_len, sq_x, sq_y_len, sq_y, lift);
 
-	float det = (A.x * (B.y - C.y) + B.x * (C.y - A.y) + C.x * (A.y - B.y)) * 2;
+	int cross_l_len = ExpansionProduct(qx_len, qx, ry_len, ry, cross_l, tmp);
+	int cross_r_len = ExpansionProduct(qy_len, qy, rx_len, rx, cross_r, tmp);
+	NegateExpansion(cross_r_len, cross_r);
+	int cross_len = ExpansionSum(cross_l_len, cross_l, cross_r_len, cross_r, cross);
 
-	res.centre_x = (1 / det) * ((A.x * A.x + A.y * A.y) * (B.y - C.y) + (B.x * B.x + B.y * B.y) * (C.y - A.y) + (C.x * C.x + C.y * C.y) * (A.y - B.y));
-	res.centre_y = (1 / det) * ((A.x * A.x + A.y * A.y) * (C.x - B.x) + (B.x * B.x + B.y * B.y) * (A.x - C.x) + (C.x * C.x + C.y * C.y) * (B.x - A.x));
-	struct Point diff;
-	diff.x = A.x - res.centre_x;
-	diff.y = A.y - res.centre_y;
-	res.radius = sqrt(diff.x * diff.x + diff.y * diff.y);
+	return ExpansionProduct(lift_len, lift, cross_len, cross, h, tmp);
+}
 
-	return res;
+// the same term when every coordinate difference is a single double, which is what float coordinates almost always give: 
+// (qx * ry - qy * rx) is scaled by px twice and by py twice instead of forming the products of expansions; h needs 32 
+int InCircleTermShort(double px, double py, double qx, double qy, double rx, double ry, double* h) {
+
+	double left[2], right[2], cross[4], x[8], xx[16], y[8], yy[16];
+	TwoProduct(qx, ry, &left[1], &left[0]);
+	TwoProduct(-qy, rx, &right[1], &right[0]);
+	int cross_len = ExpansionSum(2, left, 2, right, cross);
+
+	int x_len = ScaleExpansion(cross_len, cross, px, x);
+	int xx_len = ScaleExpansion(x_len, x, px, xx);
+	int y_len = ScaleExpansion(cross_len, cross, py, y);
+	int yy_len = ScaleExpansion(y_len, y, py, yy);
+
+	return ExpansionSum(xx_len, xx, yy_len, yy, h);
+}
+
+double InCircleExact(struct Point a, struct Point b, struct Point c, struct Point d) {
+
+	double adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+	int adx_len = DiffExpansion(a.x, d.x, adx);
+	int ady_len = DiffExpansion(a.y, d.y, ady);
+	int bdx_len = DiffExpansion(b.x, d.x, bdx);
+	int bdy_len = DiffExpansion(b.y, d.y, bdy);
+	int cdx_len = DiffExpansion(c.x, d.x, cdx);
+	int cdy_len = DiffExpansion(c.y, d.y, cdy);
+
+	if (adx_len + ady_len + bdx_len + bdy_len + cdx_len + cdy_len == 6) {
+		double short_a[32], short_b[32], short_c[32], short_ab[64], short_det[96];
+		int a_len = InCircleTermShort(adx[0], ady[0], bdx[0], bdy[0], cdx[0], cdy[0], short_a);
+		int b_len = InCircleTermShort(bdx[0], bdy[0], cdx[0], cdy[0], adx[0], ady[0], short_b);
+		int c_len = InCircleTermShort(cdx[0], cdy[0], adx[0], ady[0], bdx[0], bdy[0], short_c);
+
+		int ab_len = ExpansionSum(a_len, short_a, b_len, short_b, short_ab);
+		int det_len = ExpansionSum(ab_len, short_ab, c_len, short_c, short_det);
+		return short_det[det_len - 1];
+	}
+
+	double term_a[512], term_b[512], term_c[512], ab[1024], det[1536];
+	int a_len = InCircleTerm(adx, adx_len, ady, ady_len, bdx, bdx_len, bdy, bdy_len, cdx, cdx_len, cdy, cdy_len, term_a);
+	int b_len = InCircleTerm(bdx, bdx_len, bdy, bdy_len, cdx, cdx_len, cdy, cdy_len, adx, adx_len, ady, ady_len, term_b);
+	int c_len = InCircleTerm(cdx, cdx_len, cdy, cdy_len, adx, adx_len, ady, ady_len, bdx, bdx_len, bdy, bdy_len, term_c);
+
+	int ab_len = ExpansionSum(a_len, term_a, b_len, term_b, ab);
+	int det_len = ExpansionSum(ab_len, ab, c_len, term_c, det);
+
+	return det[det_len - 1];
+}
+
+// positive if d lies inside the circle through a, b and c when Orient(a, b, c) > 0, negative if outside, 0 if the four points are cocircular; 
+// the signs swap for a clockwise triangle 
+double InCircle(struct Point a, struct Point b, struct Point c, struct Point d) {
+
+	double adx = (double)a.x - d.x, ady = (double)a.y - d.y;
+	double bdx = (double)b.x - d.x, bdy = (double)b.y - d.y;
+	double cdx = (double)c.x - d.x, cdy = (double)c.y - d.y;
+
+	double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+	double cdxady = cdx * ady, adxcdy = adx * cdy;
+	double adxbdy = adx * bdy, bdxady = bdx * ady;
+	double alift = adx * adx + ady * ady;
+	double blift = bdx * bdx + bdy * bdy;
+	double clift = cdx * cdx + cdy * cdy;
+
+	double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+	double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift + (fabs(cdxady) + fabs(adxcdy)) * blift + (fabs(adxbdy) + fabs(bdxady)) * clift;
+
+	double bound = INCIRCLE_BOUND * permanent;
+	if (det > bound || -det > bound) return det;
+	return InCircleExact(a, b, c, d);
 }
 
-struct Triangle GetSuperTriangle(float excircle_rad, float excircle_pos_x, float excircle_pos_y, int pt_c) {
+// writes the super-triangle's vertices to points[pt_c], points[pt_c + 1] and points[pt_c + 2] 
+void GetSuperTriangle(float excircle_rad, float excircle_pos_x, float excircle_pos_y, int pt_c, struct Point* points) {
 
-	struct Triangle triangle;
 	float side_len = 2 * excircle_rad * (float)sqrt(3);
 
 	struct Point top_pt = { excircle_pos_x, excircle_pos_y - (excircle_rad + side_len / (float)sqrt(3)) };
 	top_pt.id = pt_c;
-	triangle.vertices[0] = top_pt;
+	points[pt_c] = top_pt;
 
 	struct Point left_pt = { excircle_pos_x - side_len / 2.0f, excircle_pos_y + excircle_rad };
 	left_pt.id = pt_c + 1;
-	triangle.vertices[1] = left_pt;
+	points[pt_c + 1] = left_pt;
 
 	struct Point right_pt = { excircle_pos_x + side_len / 2.0f, excircle_pos_y + excircle_rad };
 	right_pt.id = pt_c + 2;
-	triangle.vertices[2] = right_pt;
+	points[pt_c + 2] = right_pt;
+}
+
+
+
+// Scratch arena: a growable bump allocator for the triangulator's temporary buffers 
+// memory comes from a chain of blocks that are kept between uses, so once the arena has grown to a build's needs, further builds and insertions 
+// allocate nothing from the heap. Allocations are released together, by rewinding to a mark or resetting the arena 
+#define ARENA_ALIGN 16
+#define ARENA_BLOCK_SIZE (1 << 16)
 
-	struct PolyEdge one = { triangle.vertices[0].id, triangle.vertices[1].id, 0 };
-	triangle.edges[0] = one;
-	struct PolyEdge two = { triangle.vertices[1].id, triangle.vertices[2].id, 0 };
-	triangle.edges[1] = two;
-	struct PolyEdge three = { triangle.vertices[2].id, triangle.vertices[0].id, 0 };
-	triangle.edges[2] = three;
+struct ArenaBlock {
+	struct ArenaBlock* next;
+	size_t size;
+	size_t used;
+};
+
+// the block header, rounded up so that block data stays aligned 
+#define ARENA_HEADER ((sizeof(struct ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct ScratchArena {
+	struct ArenaBlock* first;
+	struct ArenaBlock* current; // NULL until the first allocation after a reset 
+	size_t in_use; // bytes handed out, counting alignment padding and block tails skipped over 
+	size_t peak; // highest in_use since the last ResetArenaPeak() 
+	void* last_alloc; // the most recent allocation, which ArenaGrow() can extend in place 
+	size_t last_size;
+	long long heap_allocs; // blocks taken from the heap since InitArena(), which FreeArena() does not reset 
+};
 
-	triangle.circumcircle = GetCircumcircle(triangle);
+struct ArenaMark {
+	struct ArenaBlock* block;
+	size_t used;
+	size_t in_use;
+};
 
-	return triangle;
+void InitArena(struct ScratchArena* arena) {
+	arena->first = NULL;
+	arena->current = NULL;
+	arena->in_use = 0;
+	arena->peak = 0;
+	arena->last_alloc = NULL;
+	arena->last_size = 0;
+	arena->heap_allocs = 0;
 }
 
-int HasEdge(struct PolyEdge edge, struct Triangle tr) {
-	if (EqualsPair(edge, tr.edges[0]) || EqualsPair(edge, tr.edges[1]) || EqualsPair(edge, tr.edges[2])) return 1;
-	else return 0;
+void FreeArena(struct ScratchArena* arena) {
+	struct ArenaBlock* block = arena->first;
+	while (block != NULL) {
+		struct ArenaBlock* next = block->next;
+		free(block);
+		block = next;
+	}
+	long long heap_allocs = arena->heap_allocs;
+	InitArena(arena);
+	arena->heap_allocs = heap_allocs;
 }
 
-// triangles array methods 
-void RemoveTriangle(int arr_size, struct Triangle* t_arr, int at_index) {
-	for (int i = at_index; i < arr_size - 1; ++i) t_arr[i] = t_arr[i + 1];
+// NULL if a new block was needed and memory ran out; the caller fails its stage, which NavMesh reports 
+void* ArenaAlloc(struct ScratchArena* arena, size_t bytes) {
+
+	bytes = (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	struct ArenaBlock* block = arena->current;
+
+	if (block == NULL || block->used + bytes > block->size) {
+
+		// move on to the next kept block, or chain in a new one in front of it if it is too small 
+		struct ArenaBlock* next = block != NULL ? block->next : arena->first;
+		if (block != NULL) arena->in_use += block->size - block->used;
+
+		if (next == NULL || next->size < bytes) {
+			size_t size = bytes > ARENA_BLOCK_SIZE ? bytes : ARENA_BLOCK_SIZE;
+			struct ArenaBlock* n_block = (struct ArenaBlock*)malloc(ARENA_HEADER + size);
+			if (n_block == NULL) return NULL;
+			++arena->heap_allocs;
+			n_block->size = size;
+			n_block->next = next;
+			if (block != NULL) block->next = n_block;
+			else arena->first = n_block;
+			next = n_block;
+		}
+
+		next->used = 0;
+		arena->current = block = next;
+	}
+
+	void* ptr = (char*)block + ARENA_HEADER + block->used;
+	block->used += bytes;
+	arena->in_use += bytes;
+	if (arena->in_use > arena->peak) arena->peak = arena->in_use;
+
+	arena->last_alloc = ptr;
+	arena->last_size = bytes;
+	return ptr;
 }
 
-struct Triangle* ResizeTrianglesArray(int arr_size, struct Triangle* t_arr) {
-	int n_size = arr_size << 1;
-	struct Triangle* n_arr = (struct Triangle*)malloc(sizeof(struct Triangle) * n_size);
+// resizes an arena allocation to new_bytes, in place if it is the most recent one and its block has room, otherwise by copying it 
+void* ArenaGrow(struct ScratchArena* arena, void* ptr, size_t old_bytes, size_t new_bytes) {
 
-	if (n_arr == NULL) {
-		printf("malloc for triangle array resize failed");
-		return NULL;
+	size_t aligned = (new_bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	struct ArenaBlock* block = arena->current;
+
+	if (ptr != NULL && ptr == arena->last_alloc && block->used - arena->last_size + aligned <= block->size) {
+		block->used += aligned - arena->last_size;
+		arena->in_use += aligned - arena->last_size;
+		if (arena->in_use > arena->peak) arena->peak = arena->in_use;
+		arena->last_size = aligned;
+		return ptr;
 	}
 
-	for (int i = 0; i < arr_size; ++i) n_arr[i] = t_arr[i];
+	void* n_ptr = ArenaAlloc(arena, new_bytes);
+	if (n_ptr != NULL && ptr != NULL) memcpy(n_ptr, ptr, old_bytes);
+	return n_ptr;
+}
 
-	free(t_arr);
+struct ArenaMark GetArenaMark(struct ScratchArena* arena) {
+	struct ArenaMark mark = { arena->current, arena->current != NULL ? arena->current->used : 0, arena->in_use };
+	return mark;
+}
 
-	return n_arr;
+// releases everything allocated since the mark was taken 
+void RewindArena(struct ScratchArena* arena, struct ArenaMark mark) {
+	arena->current = mark.block;
+	if (mark.block != NULL) mark.block->used = mark.used;
+	arena->in_use = mark.in_use;
+	arena->last_alloc = NULL;
+	arena->last_size = 0;
 }
 
+void ResetArena(struct ScratchArena* arena) {
+	arena->current = NULL;
+	arena->in_use = 0;
+	arena->last_alloc = NULL;
+	arena->last_size = 0;
+}
 
-// Triangulation algorithm 
-struct Edge* BowyerWatson(int pt_count, struct Point* points, float excircle_rad, float excircle_pos_x, float excircle_pos_y, struct Rect* obstacles, int obs_count) {
+void ResetArenaPeak(struct ScratchArena* arena) { arena->peak = arena->in_use; }
 
-	if (pt_count <= 2 || excircle_rad <= 0) return NULL; 
+// makes sure an int array allocated from the arena can hold count ints, doubling its capacity if needed 
+int* ReserveInts(struct ScratchArena* arena, int* buf, int* capacity, int count) {
+	if (count <= *capacity) return buf;
+	int n_capacity = *capacity;
+	while (n_capacity < count) n_capacity <<= 1;
+	int* n_buf = (int*)ArenaGrow(arena, buf, sizeof(int) * *capacity, sizeof(int) * n_capacity);
+	if (n_buf != NULL) *capacity = n_capacity;
+	return n_buf;
+}
 
-	int tr_arr_size = pt_count * 3;
-	float resize_threshold = 0.9f; // to check if the triangles array needs resizing 
-	struct Triangle* triangles = (struct Triangle*)malloc(sizeof(struct Triangle) * tr_arr_size);
 
-	if (triangles == NULL) {
-		printf("triangles malloc failed");
-		return NULL;
+
+// Slot-based triangle store used while triangulating 
+// a triangle is three point indices (vertices defined counterclockwise, like the super-triangle) plus the slots of the triangles across its edges; 
+// circumcircles are kept in separate arrays so the cavity search only streams the data it tests. Removed slots go on a free list and are reused, 
+// so removing a triangle is O(1) and nothing is ever shifted 
+enum TriangleState { TR_FREE = 0, TR_LIVE = 1, TR_CAVITY = 2 };
+
+struct TriangleStore {
+	int capacity;
+	int slot_count; // slots handed out so far, live or free 
+	int free_head; // first free slot, chained through adjacent[3 * slot], -1 if none 
+
+	int* vertices; // 3 per slot: edge i runs from vertices[3 * slot + i] to vertices[3 * slot + (i + 1) % 3] 
+	int* adjacent; // 3 per slot: the slot across edge i, or -1 on the super-triangle's boundary 
+	unsigned char* state;
+};
+
+int InitTriangleStore(struct TriangleStore* store, int capacity) {
+
+	store->capacity = capacity;
+	store->slot_count = 0;
+	store->free_head = -1;
+
+	store->vertices = (int*)malloc(sizeof(int) * 3 * capacity);
+	store->adjacent = (int*)malloc(sizeof(int) * 3 * capacity);
+	store->state = (unsigned char*)malloc(sizeof(unsigned char) * capacity);
+
+	if (store->vertices == NULL || store->adjacent == NULL || store->state == NULL) {
+		printf("triangle store malloc failed");
+		return 0;
 	}
+	return 1;
+}
 
-	GenObstacleEdges(obstacles, obs_count); // generate obstacle edges' slopes and y_intercepts 
+void FreeTriangleStore(struct TriangleStore* store) {
+	free(store->vertices);
+	free(store->adjacent);
+	free(store->state);
+	store->vertices = NULL;
+	store->adjacent = NULL;
+	store->state = NULL;
+	store->capacity = 0;
+	store->slot_count = 0;
+	store->free_head = -1;
+}
 
-	// I pass pt_count to super-triangle so that its Points represent the last three indices in the points array - indices at pt_count, pt_count + 1 and pt_count + 2
-	struct Triangle super_triangle = GetSuperTriangle(excircle_rad, excircle_pos_x, excircle_pos_y, pt_count);
-	triangles[0] = super_triangle;
-	for (int i = 0; i < 3; ++i) points[pt_count + i] = super_triangle.vertices[i];
-	int tr_count = 1; 
-	
-	// populates poly_edges lookup array ahead of edge-uniqueness check 
-	struct PolyEdge null_edge = { -1, -1, 1 };
+// doubles the capacity of every array; realloc moves each block at most once, instead of copying triangle by triangle 
+int GrowTriangleStore(struct TriangleStore* store) {
 
-	// Main increment loop; iterates over all points of the mesh 
-	for (int pt_i = 0; pt_i < pt_count; ++pt_i) {
+	int n_capacity = store->capacity << 1;
+
+	int* vertices = (int*)realloc(store->vertices, sizeof(int) * 3 * n_capacity);
+	if (vertices != NULL) store->vertices = vertices;
+	int* adjacent = (int*)realloc(store->adjacent, sizeof(int) * 3 * n_capacity);
+	if (adjacent != NULL) store->adjacent = adjacent;
+	unsigned char* state = (unsigned char*)realloc(store->state, sizeof(unsigned char) * n_capacity);
+	if (state != NULL) store->state = state;
+
+	if (vertices == NULL || adjacent == NULL || state == NULL) {
+		printf("realloc for triangle store resize failed");
+		return 0;
+	}
+
+	store->capacity = n_capacity;
+	return 1;
+}
+
+// returns the slot of the new triangle (a, b, c), with all three neighbours unset, or -1 if the store could not grow 
+int AddTriangle(struct TriangleStore* store, int a, int b, int c) {
+
+	int slot = store->free_head;
+	if (slot != -1) store->free_head = store->adjacent[3 * slot];
+	else {
+		if (store->slot_count == store->capacity && !GrowTriangleStore(store)) return -1;
+		slot = store->slot_count++;
+	}
 
-		struct Triangle* bad_tr = (struct Triangle*)malloc(sizeof(struct Triangle) * tr_count);
+	store->vertices[3 * slot] = a;
+	store->vertices[3 * slot + 1] = b;
+	store->vertices[3 * slot + 2] = c;
+	for (int i = 0; i < 3; ++i) store->adjacent[3 * slot + i] = -1;
+	store->state[slot] = TR_LIVE;
 
-		if (bad_tr == NULL) {
-			printf("bad triangles malloc failed");
-			return NULL;
+	return slot;
+}
+
+void RemoveTriangle(struct TriangleStore* store, int slot) {
+	store->state[slot] = TR_FREE;
+	store->adjacent[3 * slot] = store->free_head;
+	store->free_head = slot;
+}
+
+// 1 if pt lies strictly inside the circumcircle of the triangle in slot 
+int StoreCircumcircleContains(const struct TriangleStore* store, struct Point* points, int slot, struct Point pt, double orientation) {
+	const int* v = store->vertices + 3 * slot;
+	return InCircle(points[v[0]], points[v[1]], points[v[2]], pt) * orientation > 0;
+}
+
+// side of edge i of the triangle in slot that pt lies on, scaled so that positive means inside 
+double EdgeSide(const struct TriangleStore* store, struct Point* points, int slot, int i, struct Point pt, double orientation) {
+	return Orient(points[store->vertices[3 * slot + i]], points[store->vertices[3 * slot + (i + 1) % 3]], pt) * orientation;
+}
+
+// orientation is the sign shared by all triangles of the triangulation (that of the super-triangle) 
+int TriangleContains(const struct TriangleStore* store, struct Point* points, int slot, struct Point pt, double orientation) {
+	for (int i = 0; i < 3; ++i) if (EdgeSide(store, points, slot, i, pt, orientation) < 0) return 0;
+	return 1;
+}
+
+// visibility walk from triangle start towards pt, crossing any edge that has pt on its far side 
+// returns the slot of a live triangle containing pt, or -1 if pt lies outside the super-triangle 
+// the number of triangles it crosses is added to *steps 
+int LocateTriangle(const struct TriangleStore* store, struct Point* points, int start, struct Point pt, double orientation, long long* steps) {
+
+	int current = start;
+
+	// on a Delaunay triangulation the walk cannot cycle, but rounding in the circumcircle tests can leave a few non-Delaunay triangles behind 
+	for (int step = 0; step < store->slot_count; ++step) {
+
+		++*steps;
+		int next = -2;
+
+		// starting the edge checks at a different edge each step keeps the walk from circling around pt 
+		for (int k = 0; k < 3; ++k) {
+			int i = (k + step) % 3;
+			if (EdgeSide(store, points, current, i, pt, orientation) < 0) {
+				next = store->adjacent[3 * current + i];
+				break;
+			}
+		}
+
+		if (next == -2) return current;
+		if (next == -1) return -1;
+		current = next;
+	}
+
+	for (int i = 0; i < store->slot_count; ++i) if (store->state[i] == TR_LIVE && TriangleContains(store, points, i, pt, orientation)) return i;
+	return -1;
+}
+
+// the order in which BuildTriangulation() inserts the points: by index, or in biased randomized rounds sorted along a Hilbert curve (BRIO) 
+enum InsertionOrder { INSERT_INDEX = 0, INSERT_BRIO = 1 };
+
+// insertions by the size of their cavity: bucket b counts cavities of 2^(b - 1) up to 2^b - 1 triangles (bucket 0 stays empty), the last 
+// bucket the rest; the buckets are those of Metrics::Bucket() 
+#define CAVITY_BUCKETS 16
+
+// work done by point insertions, for NavMesh to report; summed over a build's strips like walk_steps 
+struct TriangulationCounters {
+	long long insertions;
+	long long circle_tests; // in-circle tests of the triangles next to a cavity 
+	long long cavity_sizes[CAVITY_BUCKETS];
+};
+
+void ResetCounters(struct TriangulationCounters* counters) {
+	counters->insertions = 0;
+	counters->circle_tests = 0;
+	for (int b = 0; b < CAVITY_BUCKETS; ++b) counters->cavity_sizes[b] = 0;
+}
+
+void AddCounters(struct TriangulationCounters* to, const struct TriangulationCounters* from) {
+	to->insertions += from->insertions;
+	to->circle_tests += from->circle_tests;
+	for (int b = 0; b < CAVITY_BUCKETS; ++b) to->cavity_sizes[b] += from->cavity_sizes[b];
+}
+
+// Persistent Delaunay triangulation, kept by NavMesh between builds so that a moved point can be re-triangulated locally 
+struct Triangulation {
+	struct TriangleStore store;
+	struct Point* points; // pt_count points, followed by the super-triangle's three vertices 
+	int pt_count;
+	int* vertex_triangle; // a live triangle around each point, -1 for points left unconnected 
+	int* fan_from; // the fan triangle that starts / ends at a given cavity boundary vertex, for linking fan triangles to each other 
+	int* fan_to;
+	double orientation; // the sign shared by all triangles of the triangulation, that of the super-triangle 
+	int last; // a triangle created by the latest insertion or removal, where walks start without a better hint 
+	int insertion_order; // an InsertionOrder, INSERT_BRIO unless changed after InitTriangulation() 
+	long long walk_steps; // triangles crossed by point location since the last BuildTriangulation() started 
+	struct TriangulationCounters counters; // since the last BuildTriangulation() started, or the owner reset them 
+};
+
+// allocates a triangulation for pt_count points; the caller fills in points[0] to points[pt_count - 1] before BuildTriangulation() 
+int InitTriangulation(struct Triangulation* tri, int pt_count) {
+
+	tri->pt_count = pt_count;
+	tri->orientation = 1.0;
+	tri->last = -1;
+	tri->insertion_order = INSERT_BRIO;
+	tri->walk_steps = 0;
+	ResetCounters(&tri->counters);
+
+	// a triangulation of n points plus the super-triangle has 2n + 1 triangles, and slots are recycled, so this rarely grows 
+	int store_ok = InitTriangleStore(&tri->store, pt_count * 2 + 16);
+	tri->points = (struct Point*)malloc(sizeof(struct Point) * (pt_count + 3));
+	tri->vertex_triangle = (int*)malloc(sizeof(int) * (pt_count + 3));
+	tri->fan_from = (int*)malloc(sizeof(int) * (pt_count + 3));
+	tri->fan_to = (int*)malloc(sizeof(int) * (pt_count + 3));
+
+	if (!store_ok || tri->points == NULL || tri->vertex_triangle == NULL || tri->fan_from == NULL || tri->fan_to == NULL) {
+		printf("triangulation malloc failed");
+		return 0;
+	}
+	return 1;
+}
+
+void FreeTriangulation(struct Triangulation* tri) {
+	FreeTriangleStore(&tri->store);
+	free(tri->points);
+	free(tri->vertex_triangle);
+	free(tri->fan_from);
+	free(tri->fan_to);
+	tri->points = NULL;
+	tri->vertex_triangle = NULL;
+	tri->fan_from = NULL;
+	tri->fan_to = NULL;
+	tri->pt_count = 0;
+	tri->last = -1;
+}
+
+// makes the triangle in slot o the neighbour across edge i of the triangle in slot tr, and tr the neighbour across the matching edge of o 
+void LinkTriangles(struct TriangleStore* store, int tr, int i, int o) {
+	store->adjacent[3 * tr + i] = o;
+	if (o == -1) return;
+
+	int a = store->vertices[3 * tr + i];
+	int b = store->vertices[3 * tr + (i + 1) % 3];
+	for (int j = 0; j < 3; ++j) {
+		if (store->vertices[3 * o + j] == b && store->vertices[3 * o + (j + 1) % 3] == a) store->adjacent[3 * o + j] = tr;
+	}
+}
+
+// inserts points[pt_i], walking to it from the triangle in slot start; its cavity (the bad triangles whose circumcircles contain it) is grown by 
+// flood fill over triangle adjacency, so an insertion only touches the triangles around the point 
+// returns the slot of one of the new triangles, -1 if the point was left unconnected (outside the super-triangle, or on top of another point), 
+// or -2 if memory ran out, which leaves the triangulation unusable 
+int InsertPoint(struct Triangulation* tri, int pt_i, int start, struct ScratchArena* scratch) {
+
+	struct TriangleStore* store = &tri->store;
+	struct Point* points = tri->points;
+	struct Point pt = points[pt_i];
+	double orientation = tri->orientation;
+
+	tri->vertex_triangle[pt_i] = -1;
+
+	int root = LocateTriangle(store, points, start, pt, orientation, &tri->walk_steps);
+	if (root == -1) return -1; // outside the super-triangle, the point is left unconnected 
+
+	// a point that duplicates a vertex is left unconnected as well 
+	for (int i = 0; i < 3; ++i) {
+		struct Point v = points[store->vertices[3 * root + i]];
+		if (v.x == pt.x && v.y == pt.y) return -1;
+	}
+
+	// per-insertion buffers, grown on demand and released on return: the cavity, and the triangles created to fill it 
+	struct ArenaMark mark = GetArenaMark(scratch);
+	int cavity_capacity = 64;
+	int* cavity = (int*)ArenaAlloc(scratch, sizeof(int) * cavity_capacity);
+	if (cavity == NULL) return -2;
+
+	// the containing triangle always belongs to the cavity, and so does the triangle across an edge the point lies on 
+	int cavity_count = 0;
+	cavity[cavity_count++] = root;
+	store->state[root] = TR_CAVITY;
+	for (int i = 0; i < 3; ++i) {
+		int across = store->adjacent[3 * root + i];
+		if (across != -1 && EdgeSide(store, points, root, i, pt, orientation) == 0) {
+			cavity[cavity_count++] = across;
+			store->state[across] = TR_CAVITY;
 		}
+	}
+
+	// get all the "bad triangles" (bad because their circumcircle contains points[pt_i]) connected to the roots, to define the polygon hole in which points[pt_i] will be triangulated
+	// the in-circle test is exact, so the hole is always star-shaped around the point and every new triangle below is properly oriented 
+	for (int c = 0; c < cavity_count; ++c) {
+		for (int i = 0; i < 3; ++i) {
 
-		int bad_tr_count = 0;
-		// get all the "bad triangles" (bad because their circumcircle contains points[pt_i]) to define the polygon hole in which points[pt_i] will be triangulated
-		for (int j = 0; j < tr_count; ++j) {
+			int next = store->adjacent[3 * cavity[c] + i];
+			if (next == -1 || store->state[next] == TR_CAVITY) continue;
+			++tri->counters.circle_tests;
+			if (!StoreCircumcircleContains(store, points, next, pt, orientation)) continue;
 
-			if (CircumcircleContains(points[pt_i], triangles[j].circumcircle)) {
-				bad_tr[bad_tr_count++] = triangles[j];
-				RemoveTriangle(tr_count, triangles, j);
-				--j;
-				--tr_count;
+			cavity = ReserveInts(scratch, cavity, &cavity_capacity, cavity_count + 1);
+			if (cavity == NULL) {
+				RewindArena(scratch, mark);
+				return -2;
+			}
+			cavity[cavity_count++] = next;
+			store->state[next] = TR_CAVITY;
+		}
+	}
+
+	int bucket = 0;
+	for (int size = cavity_count; size > 0 && bucket < CAVITY_BUCKETS - 1; size >>= 1) ++bucket;
+	++tri->counters.cavity_sizes[bucket];
+	++tri->counters.insertions;
+
+	// at most one new triangle per cavity edge 
+	int* fan = (int*)ArenaAlloc(scratch, sizeof(int) * cavity_count * 3);
+	if (fan == NULL) {
+		RewindArena(scratch, mark);
+		return -2;
+	}
+
+	// create new triangles out of the polygon hole's edges and the point 
+	int fan_count = 0;
+	for (int c = 0; c < cavity_count; ++c) {
+		for (int i = 0; i < 3; ++i) {
+
+			int bad = cavity[c];
+			int outside = store->adjacent[3 * bad + i];
+			if (outside != -1 && store->state[outside] == TR_CAVITY) continue;
+
+			int a = store->vertices[3 * bad + i];
+			int b = store->vertices[3 * bad + (i + 1) % 3];
+
+			int index = AddTriangle(store, pt_i, a, b);
+			if (index == -1) {
+				RewindArena(scratch, mark);
+				return -2;
+			}
+			store->adjacent[3 * index + 1] = outside;
+
+			// the triangle outside the hole now borders the new triangle instead of the bad one 
+			if (outside != -1) {
+				for (int j = 0; j < 3; ++j) if (store->adjacent[3 * outside + j] == bad) store->adjacent[3 * outside + j] = index;
 			}
 
+			tri->fan_from[a] = index;
+			tri->fan_to[b] = index;
+			tri->vertex_triangle[a] = index; // every vertex of a bad triangle lies on the hole's boundary and gets a new triangle 
+			fan[fan_count++] = index;
 		}
+	}
+
+	// new triangles (pt, a, b) border the new triangle ending at a and the one starting at b 
+	for (int f = 0; f < fan_count; ++f) {
+		int tr = fan[f];
+		store->adjacent[3 * tr] = tri->fan_to[store->vertices[3 * tr + 1]];
+		store->adjacent[3 * tr + 2] = tri->fan_from[store->vertices[3 * tr + 2]];
+	}
+
+	// new triangles were added before the bad ones were freed, so no slot of the cavity was reused while it was still being read 
+	for (int c = 0; c < cavity_count; ++c) RemoveTriangle(store, cavity[c]);
+
+	int res = fan[0];
+	tri->last = res;
+	tri->vertex_triangle[pt_i] = res;
+
+	RewindArena(scratch, mark);
+	return res;
+}
+
+// spreads the low 16 bits of v over the even bits 
+unsigned int InterleaveBits(unsigned int v) {
+	v = (v | (v << 8)) & 0x00ff00ffu;
+	v = (v | (v << 4)) & 0x0f0f0f0fu;
+	v = (v | (v << 2)) & 0x33333333u;
+	v = (v | (v << 1)) & 0x55555555u;
+	return v;
+}
+
+// position of (x, y) along a Hilbert curve over a 65536 x 65536 grid 
+// rather than descending the quadrants one bit at a time, which branches on every bit, the quadrant rotations are composed for all 16 
+// levels at once with a parallel prefix scan over the bits of x and y (4 rounds of 2 bits, 4, 8 and 16 levels) 
+unsigned int HilbertIndex(unsigned int x, unsigned int y) {
+
+	unsigned int a = x ^ y;
+	unsigned int b = 0xffff ^ a;
+	unsigned int c = 0xffff ^ (x | y);
+	unsigned int d = x & (y ^ 0xffff);
+
+	unsigned int A = a | (b >> 1);
+	unsigned int B = (a >> 1) ^ a;
+	unsigned int C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+	unsigned int D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+	for (int shift = 2; shift <= 8; shift <<= 1) {
+		a = A;
+		b = B;
+		c = C;
+		d = D;
+		A = (a & (a >> shift)) ^ (b & (b >> shift));
+		B = (a & (b >> shift)) ^ (b & ((a ^ b) >> shift));
+		C ^= (a & (c >> shift)) ^ (b & (d >> shift));
+		D ^= (b & (c >> shift)) ^ ((a ^ b) & (d >> shift));
+	}
 
-		// representing the polygon hole with poly_edges lookup array, consisting of all unique edges of the bad triangles
-		int edges_arr_size = bad_tr_count * 3; 
-		struct PolyEdge* poly_edges = (struct PolyEdge*)malloc(sizeof(struct PolyEdge) * edges_arr_size);
-		for (int i = 0; i < edges_arr_size; ++i) poly_edges[i] = null_edge; 
+	a = C ^ (C >> 1);
+	b = D ^ (D >> 1);
+	unsigned int i0 = x ^ y;
+	unsigned int i1 = b | (0xffff ^ (i0 | a));
+	return (InterleaveBits(i1) << 1) | InterleaveBits(i0);
+}
 
-		if (poly_edges == NULL) {
-			printf("poly edges malloc failed");
-			return NULL;
+// writes the BRIO insertion order of the points to order: every point falls in the last round with probability 1/2, otherwise in the one before 
+// with probability 1/2, and so on, and each round is sorted along a Hilbert curve over the bounding box (min_x, min_y, max_x, max_y) 
+// the small early rounds spread over the whole area and keep the triangulation balanced, while within a round consecutive points lie close 
+// together, so walks are short and insertions touch recently used triangles; the rounds come from a hash of the point index, not from rand(), 
+// so the order (and with it any tie between cocircular points) is the same on every build. Returns 0 if scratch ran out 
+int GetBrioOrder(const struct Point* points, int pt_count, float min_x, float min_y, float max_x, float max_y, struct ScratchArena* scratch, int* order) {
+
+	// about 64 points in the first round 
+	int rounds = 1;
+	while (rounds < 24 && (pt_count >> rounds) > 64) ++rounds;
+
+	unsigned long long* keys = (unsigned long long*)ArenaAlloc(scratch, sizeof(unsigned long long) * 2 * pt_count);
+	if (keys == NULL) return 0;
+	unsigned long long* keys_out = keys + pt_count;
+
+	// each point is sorted as one word: its round in the top 5 bits, its Hilbert index (to 2^-13.5 of the box) in the next 27, its index in the low 32 
+	double scale_x = max_x > min_x ? 65535.0 / ((double)max_x - min_x) : 0.0;
+	double scale_y = max_y > min_y ? 65535.0 / ((double)max_y - min_y) : 0.0;
+	for (int i = 0; i < pt_count; ++i) {
+
+		unsigned int hash = (unsigned int)i * 0x9e3779b9u;
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+		unsigned int round = rounds - 1;
+		while (round > 0 && (hash & 1)) {
+			--round;
+			hash >>= 1;
 		}
 
-		if (bad_tr_count == 1) { // if only one bad triangle, all edges are unique 
-			for (int i = 0; i < 3; ++i) poly_edges[i] = bad_tr[0].edges[i];
+		unsigned int x = (unsigned int)(((double)points[i].x - min_x) * scale_x);
+		unsigned int y = (unsigned int)(((double)points[i].y - min_y) * scale_y);
+		unsigned int key = (round << 27) | (HilbertIndex(x, y) >> 5);
+		keys[i] = ((unsigned long long)key << 32) | (unsigned int)i;
+	}
+
+	// least significant digit radix sort on the top 32 bits, 11 bits per pass 
+	unsigned long long* keys_in = keys;
+	for (int shift = 32; shift < 64; shift += 11) {
+
+		int counts[2049] = { 0 };
+		for (int i = 0; i < pt_count; ++i) ++counts[((keys_in[i] >> shift) & 0x7ff) + 1];
+		for (int b = 0; b < 2048; ++b) counts[b + 1] += counts[b];
+		for (int i = 0; i < pt_count; ++i) keys_out[counts[(keys_in[i] >> shift) & 0x7ff]++] = keys_in[i];
+
+		unsigned long long* swap_keys = keys_in;
+		keys_in = keys_out;
+		keys_out = swap_keys;
+	}
+	for (int i = 0; i < pt_count; ++i) order[i] = (int)(keys_in[i] & 0xffffffffu);
+
+	return 1;
+}
+
+// Triangulation stage of BowyerWatson(): triangulates tri->points from scratch, replacing whatever tri held 
+// all temporary buffers come from scratch, which is reset on entry; a point insertion allocates nothing from the heap once the arena is warm 
+int BuildTriangulation(struct Triangulation* tri, float excircle_rad, float excircle_pos_x, float excircle_pos_y, struct ScratchArena* scratch) {
+
+	int pt_count = tri->pt_count;
+	struct Point* points = tri->points;
+	if (pt_count <= 2 || excircle_rad <= 0) return 0; 
+
+	struct TriangleStore* store = &tri->store;
+	store->slot_count = 0;
+	store->free_head = -1;
+
+	ResetArena(scratch);
+
+	// walks on randomly ordered points would cross O(sqrt(n)) triangles from the last insertion, so a pyramid of grids over the points (sides 1, 2, 4, ...) 
+	// remembers the last point inserted in each cell; the walk starts from a live triangle around the point found in the finest non-empty cell 
+	float min_x = points[0].x, max_x = points[0].x, min_y = points[0].y, max_y = points[0].y;
+	for (int i = 1; i < pt_count; ++i) {
+		min_x = fminf(min_x, points[i].x);
+		max_x = fmaxf(max_x, points[i].x);
+		min_y = fminf(min_y, points[i].y);
+		max_y = fmaxf(max_y, points[i].y);
+	}
+	int hint_levels = 1;
+	while ((1 << (hint_levels - 1)) * (1 << (hint_levels - 1)) * 2 < pt_count) ++hint_levels; // about two points per cell on the finest level 
+	int hint_side = 1 << (hint_levels - 1);
+	int hint_size = 0; 
+	for (int l = 0; l < hint_levels; ++l) hint_size += (1 << l) * (1 << l);
+	float hint_cell_w = (max_x - min_x) / hint_side + 1e-6f;
+	float hint_cell_h = (max_y - min_y) / hint_side + 1e-6f;
+	int* hints = (int*)ArenaAlloc(scratch, sizeof(int) * hint_size);
+
+	if (hints == NULL) {
+		printf("triangulation malloc failed");
+		return 0;
+	}
+	for (int i = 0; i < hint_size; ++i) hints[i] = -1;
+	for (int i = 0; i < pt_count + 3; ++i) tri->vertex_triangle[i] = -1;
+	tri->walk_steps = 0;
+	ResetCounters(&tri->counters);
+
+	// the points keep their indices whatever the order they are inserted in 
+	int* order = NULL;
+	if (tri->insertion_order == INSERT_BRIO) {
+		order = (int*)ArenaAlloc(scratch, sizeof(int) * pt_count);
+		struct ArenaMark mark = GetArenaMark(scratch);
+		if (order == NULL || !GetBrioOrder(points, pt_count, min_x, min_y, max_x, max_y, scratch, order)) {
+			printf("triangulation malloc failed");
+			return 0;
 		}
-		else {
-			// checking if the edges are unique 
-			for (int i = 0; i < bad_tr_count; ++i) {
-				for (int j = 0; j < 3; ++j) {
-
-					struct PolyEdge next = bad_tr[i].edges[j];
-					int lookup_index = (next.start ^ next.end) * 7 % edges_arr_size;
-
-					// open addressing with linear probing of poly_edges until either an empty slot is found, or an equal edge is found (increment unique struct member, to then 
-					// skip the edges for which (unique > 0), when triangulating the point)
-					while (1) {
-						if (poly_edges[lookup_index].start == -1) {
-							poly_edges[lookup_index] = next;
-							break;
-						}
-						if (EqualsPair(poly_edges[lookup_index], next)) {
-							++poly_edges[lookup_index].unique;
-							break; 
-						}
-						lookup_index = (lookup_index + 1) % edges_arr_size;
-					}
+		RewindArena(scratch, mark); // releases the sort buffers, order stays 
+	}
+
+	// I pass pt_count to super-triangle so that its Points represent the last three indices in the points array - indices at pt_count, pt_count + 1 and pt_count + 2
+	GetSuperTriangle(excircle_rad, excircle_pos_x, excircle_pos_y, pt_count, points);
+	tri->last = AddTriangle(store, pt_count, pt_count + 1, pt_count + 2);
+	if (tri->last == -1) return 0;
+	for (int i = 0; i < 3; ++i) tri->vertex_triangle[pt_count + i] = tri->last;
+
+	// every triangle keeps the super-triangle's winding 
+	tri->orientation = Orient(points[pt_count], points[pt_count + 1], points[pt_count + 2]) < 0 ? -1.0 : 1.0;
+
+	int failed = 0;
+
+	// Main increment loop; iterates over all points of the mesh 
+	for (int k = 0; k < pt_count && !failed; ++k) {
+
+		int pt_i = order != NULL ? order[k] : k;
+		struct Point pt = points[pt_i];
+
+		int hint_x = (int)((pt.x - min_x) / hint_cell_w);
+		int hint_y = (int)((pt.y - min_y) / hint_cell_h);
+		hint_x = hint_x < 0 ? 0 : hint_x >= hint_side ? hint_side - 1 : hint_x;
+		hint_y = hint_y < 0 ? 0 : hint_y >= hint_side ? hint_side - 1 : hint_y;
+
+		int start = tri->last;
+		for (int l = hint_levels - 1, level_offset = hint_size - hint_side * hint_side; l >= 0; --l) {
+			int shift = hint_levels - 1 - l;
+			int hint = hints[level_offset + (hint_y >> shift) * (1 << l) + (hint_x >> shift)];
+			if (hint != -1) {
+				start = tri->vertex_triangle[hint];
+				break;
+			}
+			if (l > 0) level_offset -= (1 << (l - 1)) * (1 << (l - 1));
+		}
+
+		int inserted = InsertPoint(tri, pt_i, start, scratch);
+		if (inserted == -2) failed = 1;
+		if (inserted < 0) continue;
+
+		for (int l = 0, level_offset = 0; l < hint_levels; level_offset += (1 << l) * (1 << l), ++l) {
+			int shift = hint_levels - 1 - l;
+			hints[level_offset + (hint_y >> shift) * (1 << l) + (hint_x >> shift)] = pt_i;
+		}
+	}
+
+	ResetArena(scratch);
+	return !failed;
+}
+
+// returns the live triangles that do not share vertices with the super triangle, as three point ids per triangle, and writes their number to tr_count_out 
+int* CollectTriangles(const struct Triangulation* tri, int* tr_count_out) {
+
+	const struct TriangleStore* store = &tri->store;
+	int pt_count = tri->pt_count;
+
+	*tr_count_out = 0;
+	int* triangles = (int*)malloc(sizeof(int) * 3 * (store->slot_count + 1));
+	if (triangles == NULL) return NULL;
+
+	int tr_count = 0;
+	for (int i = 0; i < store->slot_count; ++i) {
+		if (store->state[i] != TR_LIVE) continue;
+		if (store->vertices[3 * i] >= pt_count || store->vertices[3 * i + 1] >= pt_count || store->vertices[3 * i + 2] >= pt_count) continue;
+		for (int j = 0; j < 3; ++j) triangles[3 * tr_count + j] = store->vertices[3 * i + j];
+		++tr_count;
+	}
+
+	if (tr_count == 0) {
+		free(triangles);
+		return NULL;
+	}
+
+	*tr_count_out = tr_count;
+	return triangles;
+}
+
+// writes the vertices connected to points[pt_i] to link (up to capacity of them, super-triangle vertices included) in winding order, 
+// and returns their number; 0 for a point left unconnected 
+int GetVertexLink(const struct Triangulation* tri, int pt_i, int* link, int capacity) {
+
+	const struct TriangleStore* store = &tri->store;
+	int first = tri->vertex_triangle[pt_i];
+	if (first == -1) return 0;
+
+	int count = 0;
+	int tr = first;
+	do {
+		int i = 0;
+		while (i < 3 && store->vertices[3 * tr + i] != pt_i) ++i;
+		if (i == 3 || count > store->slot_count) return count; // a stale vertex_triangle; cannot happen on a consistent store 
+
+		if (count < capacity) link[count] = store->vertices[3 * tr + (i + 1) % 3];
+		++count;
+
+		// the triangle across the edge from the last vertex back to pt_i is the next one around it 
+		tr = store->adjacent[3 * tr + (i + 2) % 3];
+	} while (tr != first && tr != -1);
+
+	return count;
+}
+
+// removes points[pt_i] from the triangulation: its star is taken out and the hole re-triangulated by clipping Delaunay ears, i.e. convex corners 
+// of the hole whose circumcircle holds no other vertex of the hole; returns 0 if memory ran out, which leaves the triangulation unusable 
+int RemovePoint(struct Triangulation* tri, int pt_i, struct ScratchArena* scratch) {
+
+	struct TriangleStore* store = &tri->store;
+	struct Point* points = tri->points;
+
+	int first = tri->vertex_triangle[pt_i];
+	if (first == -1) return 1; // nothing to remove 
+
+	struct ArenaMark mark = GetArenaMark(scratch);
+	int capacity = 16;
+	int* hole = (int*)ArenaAlloc(scratch, sizeof(int) * capacity); // the hole's vertices in winding order 
+	int* outside = (int*)ArenaAlloc(scratch, sizeof(int) * capacity); // the triangle across the hole edge from hole[k] to hole[k + 1] 
+	if (hole == NULL || outside == NULL) {
+		RewindArena(scratch, mark);
+		return 0;
+	}
+
+	// walk around the point, as in GetVertexLink(), freeing its star as it goes; slots are only reused once the hole is being filled 
+	int count = 0;
+	int tr = first;
+	do {
+		int i = 0;
+		while (i < 3 && store->vertices[3 * tr + i] != pt_i) ++i;
+
+		if (count == capacity) {
+			int n_capacity = capacity;
+			hole = ReserveInts(scratch, hole, &n_capacity, count + 1);
+			outside = ReserveInts(scratch, outside, &capacity, count + 1);
+			if (hole == NULL || outside == NULL) {
+				RewindArena(scratch, mark);
+				return 0;
+			}
+		}
+		hole[count] = store->vertices[3 * tr + (i + 1) % 3];
+		outside[count++] = store->adjacent[3 * tr + (i + 1) % 3];
+
+		int next = store->adjacent[3 * tr + (i + 2) % 3];
+		RemoveTriangle(store, tr);
+		tr = next;
+	} while (tr != first && tr != -1);
+
+	tri->vertex_triangle[pt_i] = -1;
+
+	while (count >= 3) {
+
+		// a Delaunay ear, or failing that (a hole that is not a vertex link, e.g. around a point that was never connected) any convex corner with no hole vertex inside it 
+		int ear = -1;
+		for (int pass = 0; pass < 2 && ear == -1; ++pass) {
+			for (int k = 0; k < count && ear == -1; ++k) {
+
+				struct Point a = points[hole[k]];
+				struct Point b = points[hole[(k + 1) % count]];
+				struct Point c = points[hole[(k + 2) % count]];
+				if (Orient(a, b, c) * tri->orientation <= 0) continue;
+
+				int empty = 1;
+				for (int m = 3; m < count && empty; ++m) {
+					struct Point other = points[hole[(k + m) % count]];
+					if (pass == 0) empty = !(InCircle(a, b, c, other) * tri->orientation > 0);
+					else empty = !(Orient(a, b, other) * tri->orientation > 0 && Orient(b, c, other) * tri->orientation > 0 && Orient(c, a, other) * tri->orientation > 0);
 				}
+				if (empty) ear = k;
 			}
 		}
+		if (ear == -1) ear = 0; // a degenerate hole; clipping anyway keeps the store consistent 
+
+		int b_k = (ear + 1) % count;
+		int n_tr = AddTriangle(store, hole[ear], hole[b_k], hole[(ear + 2) % count]);
+		if (n_tr == -1) {
+			RewindArena(scratch, mark);
+			return 0;
+		}
+		LinkTriangles(store, n_tr, 0, outside[ear]);
+		LinkTriangles(store, n_tr, 1, outside[b_k]);
+		if (count == 3) LinkTriangles(store, n_tr, 2, outside[(ear + 2) % count]);
+		for (int i = 0; i < 3; ++i) tri->vertex_triangle[store->vertices[3 * n_tr + i]] = n_tr;
+		tri->last = n_tr;
+
+		// the ear's tip leaves the hole, whose new edge from hole[ear] to hole[ear + 2] borders the ear 
+		outside[ear] = n_tr;
+		for (int k = b_k; k + 1 < count; ++k) {
+			hole[k] = hole[k + 1];
+			outside[k] = outside[k + 1];
+		}
+		if (count == 3) break;
+		--count;
+	}
+
+	RewindArena(scratch, mark);
+	return 1;
+}
 
-		// create new triangles out of the polygon and add them to triangles 
-		for (int i = 0; i < edges_arr_size; ++i) {
+// moves points[pt_i] to (x, y) by removing it and inserting it again, so only the triangles around its old and new positions change 
+// returns 0 if memory ran out, which leaves the triangulation unusable 
+int MovePoint(struct Triangulation* tri, int pt_i, float x, float y, struct ScratchArena* scratch) {
 
-			if (poly_edges[i].unique > 0) continue;
+	if (!RemovePoint(tri, pt_i, scratch)) return 0;
 
-			struct Triangle next;
-			next.vertices[0] = points[pt_i];
-			// the id of a Point also happens to be the index of this Point in the cpoints array; PolyEdge stores the ids of these points instead of the Point instances themselves 
-			next.vertices[1] = points[poly_edges[i].start];
-			next.vertices[2] = points[poly_edges[i].end];
+	tri->points[pt_i].x = x;
+	tri->points[pt_i].y = y;
 
-			// generate the edges 
-			struct PolyEdge one = { next.vertices[0].id, next.vertices[1].id, 0 };
-			next.edges[0] = one;
-			struct PolyEdge two = { next.vertices[1].id, next.vertices[2].id, 0 };
-			next.edges[1] = two;
-			struct PolyEdge three = { next.vertices[2].id, next.vertices[0].id, 0 };
-			next.edges[2] = three;
+	// the last triangle of the removal lies where the point was, a few pixels away when it is being dragged 
+	return InsertPoint(tri, pt_i, tri->last, scratch) != -2;
+}
 
-			next.circumcircle = GetCircumcircle(next);
-			triangles[tr_count++] = next;
+// returns the Delaunay triangles of points with the super-triangle removed, as three point ids per triangle, and writes their number to tr_count_out 
+int* Triangulate(int pt_count, struct Point* points, float excircle_rad, float excircle_pos_x, float excircle_pos_y, struct ScratchArena* scratch, int* tr_count_out) {
 
-			if (tr_count / (float)tr_arr_size > resize_threshold) { // in case the new triangle addition crossed the resize_threshold 
-				triangles = ResizeTrianglesArray(tr_arr_size, triangles);
-				tr_arr_size = tr_arr_size << 1;
+	*tr_count_out = 0;
+	if (pt_count <= 2 || excircle_rad <= 0) return NULL; 
+
+	struct Triangulation tri;
+	int* triangles = NULL;
+	if (InitTriangulation(&tri, pt_count)) {
+		memcpy(tri.points, points, sizeof(struct Point) * pt_count);
+		if (BuildTriangulation(&tri, excircle_rad, excircle_pos_x, excircle_pos_y, scratch)) triangles = CollectTriangles(&tri, tr_count_out);
+	}
+	FreeTriangulation(&tri);
+
+	return triangles;
+}
+
+// Parallel construction 
+// the points are split into vertical strips (by x rank), and every strip is triangulated on its own, together with the same super-triangle 
+// a strip triangle whose circumcircle lies strictly between the neighbouring strips' points is Delaunay for the whole point set, and final; 
+// the vertices of all the other triangles form the seam, which is triangulated once more, and the seam triangles outside the final ones 
+// fill the rest of the mesh. When no four points of the result are cocircular the Delaunay triangulation is unique, so the merged triangles 
+// are exactly those of the serial build; the merge refuses (returns 0) whenever it cannot prove that, and the caller builds serially instead 
+
+// what a strip hands over to MergeStrips(); all ids are global: points keep theirs in Point.id, and the super-triangle's vertices are 
+// pt_count, pt_count + 1 and pt_count + 2. The final triangles come in store layout, already linked to each other, so that the merge 
+// copies them in one block per strip and only links the walls anew 
+struct StripResult {
+	int* triangles; // final triangles, 3 ids each 
+	int* adjacent; // 3 per final triangle: the index of the final triangle across edge i, or -1 across a wall 
+	int tr_count;
+	int* walls; // edges between a final and a non-final triangle, as 3 * final triangle + edge 
+	int wall_count;
+	int* seam; // points with a non-final triangle around them 
+	int seam_count;
+	int degenerate; // cocircular final triangles or an unconnected point; the strips cannot be merged exactly 
+	long long walk_steps; // the strip triangulation's point location steps 
+	struct TriangulationCounters counters;
+};
+
+void InitStripResult(struct StripResult* res) {
+	res->triangles = NULL;
+	res->adjacent = NULL;
+	res->walls = NULL;
+	res->seam = NULL;
+	res->tr_count = 0;
+	res->wall_count = 0;
+	res->seam_count = 0;
+	res->degenerate = 0;
+	res->walk_steps = 0;
+	ResetCounters(&res->counters);
+}
+
+void FreeStripResult(struct StripResult* res) {
+	free(res->triangles);
+	free(res->adjacent);
+	free(res->walls);
+	free(res->seam);
+	InitStripResult(res);
+}
+
+// global id of a vertex of the triangulation over a subset of global_count points 
+int GlobalVertex(const struct Triangulation* tri, int v, int global_count) {
+	return v < tri->pt_count ? tri->points[v].id : global_count + v - tri->pt_count;
+}
+
+// whether the circumcircle of (a, b, c) lies strictly between x = lo and x = hi; the margin makes up for the rounding of the centre and 
+// radius, so that a circle is only ever reported inside by mistake by being rejected (leaving more work to the seam) 
+int CircumcircleBetween(struct Point a, struct Point b, struct Point c, double lo, double hi) {
+
+	double bx = (double)b.x - a.x, by = (double)b.y - a.y;
+	double cx = (double)c.x - a.x, cy = (double)c.y - a.y;
+	double det = 2.0 * (bx * cy - by * cx);
+	if (det == 0.0) return 0;
+
+	double b_sq = bx * bx + by * by, c_sq = cx * cx + cy * cy;
+	double ux = (cy * b_sq - by * c_sq) / det;
+	double uy = (bx * c_sq - cx * b_sq) / det;
+	double radius = sqrt(ux * ux + uy * uy);
+	double centre = a.x + ux;
+	double margin = 1e-6 * (fabs(centre) + radius) + 1e-6;
+
+	return centre - radius - margin > lo && centre + radius + margin < hi;
+}
+
+// triangulates strip (its points filled in, with their global ids) and sorts its triangles into final ones and seam ones; lo and hi are 
+// the x of the nearest points of the strips to the left and right (-HUGE_VAL / HUGE_VAL at the ends) 
+// returns 0 if memory ran out; an input the strips cannot be merged over sets res->degenerate instead 
+int BuildStrip(struct Triangulation* strip, double lo, double hi, float excircle_rad, float excircle_pos_x, float excircle_pos_y, 
+	struct ScratchArena* scratch, struct StripResult* res) {
+
+	InitStripResult(res);
+	if (!BuildTriangulation(strip, excircle_rad, excircle_pos_x, excircle_pos_y, scratch)) return 0;
+	res->walk_steps = strip->walk_steps;
+	res->counters = strip->counters;
+
+	const struct TriangleStore* store = &strip->store;
+	struct Point* points = strip->points;
+	int pt_count = strip->pt_count;
+
+	for (int i = 0; i < pt_count; ++i) if (strip->vertex_triangle[i] == -1) res->degenerate = 1;
+
+	// the index every final slot will have among the strip's final triangles, -1 for the others 
+	int* final = (int*)ArenaAlloc(scratch, sizeof(int) * (store->slot_count + 1));
+	unsigned char* on_seam = (unsigned char*)ArenaAlloc(scratch, pt_count + 1);
+	if (final == NULL || on_seam == NULL) {
+		ResetArena(scratch);
+		return 0;
+	}
+	memset(on_seam, 0, pt_count);
+
+	int final_count = 0, wall_count = 0;
+	for (int i = 0; i < store->slot_count; ++i) {
+		const int* v = store->vertices + 3 * i;
+		int is_final = store->state[i] == TR_LIVE && v[0] < pt_count && v[1] < pt_count && v[2] < pt_count
+			&& CircumcircleBetween(points[v[0]], points[v[1]], points[v[2]], lo, hi);
+		final[i] = is_final ? final_count++ : -1;
+		if (!is_final && store->state[i] == TR_LIVE) for (int j = 0; j < 3; ++j) if (v[j] < pt_count) on_seam[v[j]] = 1;
+	}
+	for (int i = 0; i < store->slot_count; ++i) {
+		if (final[i] == -1) continue;
+		for (int j = 0; j < 3; ++j) if (final[store->adjacent[3 * i + j]] == -1) ++wall_count;
+	}
+
+	int seam_count = 0;
+	for (int i = 0; i < pt_count; ++i) seam_count += on_seam[i];
+
+	res->triangles = (int*)malloc(sizeof(int) * 3 * (final_count + 1));
+	res->adjacent = (int*)malloc(sizeof(int) * 3 * (final_count + 1));
+	res->walls = (int*)malloc(sizeof(int) * (wall_count + 1));
+	res->seam = (int*)malloc(sizeof(int) * (seam_count + 1));
+	if (res->triangles == NULL || res->adjacent == NULL || res->walls == NULL || res->seam == NULL) {
+		FreeStripResult(res);
+		ResetArena(scratch);
+		return 0;
+	}
+
+	for (int i = 0; i < pt_count; ++i) if (on_seam[i]) res->seam[res->seam_count++] = points[i].id;
+
+	for (int i = 0; i < store->slot_count; ++i) {
+		if (final[i] == -1) continue;
+
+		const int* v = store->vertices + 3 * i;
+		int t = res->tr_count++;
+		for (int j = 0; j < 3; ++j) res->triangles[3 * t + j] = points[v[j]].id;
+
+		// a final triangle has no super-triangle vertex, so all three of its neighbours exist 
+		for (int j = 0; j < 3; ++j) {
+			int o = store->adjacent[3 * i + j];
+			res->adjacent[3 * t + j] = final[o];
+			if (final[o] == -1) {
+				res->walls[res->wall_count++] = 3 * t + j;
+				continue;
 			}
+
+			// two final neighbours: the vertex across the edge must be strictly outside, or another triangulation would be as valid 
+			if (o < i) continue;
+			int d = -1;
+			for (int k = 0; k < 3; ++k) if (store->adjacent[3 * o + k] == i) d = store->vertices[3 * o + (k + 2) % 3];
+			if (d == -1 || InCircle(points[v[0]], points[v[1]], points[v[2]], points[d]) == 0) res->degenerate = 1;
 		}
+	}
+
+	ResetArena(scratch);
+	return 1;
+}
+
+// Directed edge to int hash table for MergeStrips(), open addressing with linear probing, allocated from scratch 
+struct EdgeTable {
+	int size;
+	int* keys; // start and end of every entry, start -1 if empty 
+	int* values;
+};
+
+int InitEdgeTable(struct EdgeTable* table, int entries, struct ScratchArena* scratch) {
+	table->size = entries * 2 + 1;
+	table->keys = (int*)ArenaAlloc(scratch, sizeof(int) * 2 * table->size);
+	table->values = (int*)ArenaAlloc(scratch, sizeof(int) * table->size);
+	if (table->keys == NULL || table->values == NULL) return 0;
+	for (int i = 0; i < table->size; ++i) table->keys[2 * i] = -1;
+	return 1;
+}
 
-		free(poly_edges);
-		free(bad_tr);
+int EdgeSlot(const struct EdgeTable* table, int start, int end) {
+	unsigned int hash = (unsigned int)start * 2654435761u ^ (unsigned int)end * 40503u;
+	int i = (int)(hash % (unsigned int)table->size);
+	while (table->keys[2 * i] != -1 && (table->keys[2 * i] != start || table->keys[2 * i + 1] != end)) i = (i + 1) % table->size;
+	return i;
+}
+
+void InsertEdge(struct EdgeTable* table, int start, int end, int value) {
+	int i = EdgeSlot(table, start, end);
+	table->keys[2 * i] = start;
+	table->keys[2 * i + 1] = end;
+	table->values[i] = value;
+}
+
+// the value stored for the directed edge, or -1 
+int FindEdge(const struct EdgeTable* table, int start, int end) {
+	int i = EdgeSlot(table, start, end);
+	return table->keys[2 * i] == -1 ? -1 : table->values[i];
+}
+
+// merges the strips into tri, whose points (all of them, with id == index) are already filled in; the strips must have been built with 
+// the same super-triangle. The final triangles are copied into the store strip by strip, keeping their links, and only the kept seam 
+// triangles and the walls they meet are linked anew, so the serial part of the merge is a copy plus work on the seam 
+// Returns 1 on success, 0 if the strips cannot be merged exactly or memory ran out - tri is then to be rebuilt serially 
+int MergeStrips(struct Triangulation* tri, const struct StripResult* strips, int strip_count, float excircle_rad, float excircle_pos_x, float excircle_pos_y, 
+	struct ScratchArena* scratch) {
+
+	int pt_count = tri->pt_count;
+	int seam_count = 0, final_count = 0, wall_count = 0;
+	for (int s = 0; s < strip_count; ++s) {
+		if (strips[s].degenerate) return 0;
+		seam_count += strips[s].seam_count;
+		final_count += strips[s].tr_count;
+		wall_count += strips[s].wall_count;
+	}
+	if (seam_count <= 2) return 0;
+
+	// the seam points are triangulated with the same super-triangle, first, as BuildTriangulation() resets scratch 
+	struct Triangulation seam;
+	int ok = InitTriangulation(&seam, seam_count);
+	if (ok) {
+		seam.insertion_order = tri->insertion_order;
+		for (int s = 0, n = 0; s < strip_count; ++s) for (int i = 0; i < strips[s].seam_count; ++i) seam.points[n++] = tri->points[strips[s].seam[i]];
+		ok = BuildTriangulation(&seam, excircle_rad, excircle_pos_x, excircle_pos_y, scratch);
+	}
+	for (int i = 0; ok && i < seam_count; ++i) if (seam.vertex_triangle[i] == -1) ok = 0;
+	if (!ok) {
+		FreeTriangulation(&seam);
+		return 0;
 	}
 
-	// loop through all triangles and remove any that share vertices with the super triangle 
-	for (int i = 0; i < tr_count; ++i) {
+	GetSuperTriangle(excircle_rad, excircle_pos_x, excircle_pos_y, pt_count, tri->points);
+	tri->orientation = seam.orientation;
+	tri->walk_steps = seam.walk_steps;
+	tri->counters = seam.counters;
+	for (int s = 0; s < strip_count; ++s) {
+		tri->walk_steps += strips[s].walk_steps;
+		AddCounters(&tri->counters, &strips[s].counters);
+	}
+	struct Point* points = tri->points;
+	const struct TriangleStore* seam_store = &seam.store;
+	int seam_slots = seam_store->slot_count;
+
+	// seam triangles on the final side of a wall edge, and those connected to them without crossing one, overlap the final triangles; 
+	// a wall edge is blocked on both sides, and on the seam side it remembers the final triangle's opposite vertex and its edge in the 
+	// merged store, strip s's final triangles going to the slots from the sum of the earlier strips' counts on 
+	struct EdgeTable seam_edges;
+	unsigned char* blocked = (unsigned char*)ArenaAlloc(scratch, 3 * seam_slots + 1);
+	int* wall_opposite = (int*)ArenaAlloc(scratch, sizeof(int) * (3 * seam_slots + 1));
+	int* wall_edge = (int*)ArenaAlloc(scratch, sizeof(int) * (3 * seam_slots + 1));
+	unsigned char* covered = (unsigned char*)ArenaAlloc(scratch, seam_slots + 1);
+	int* stack = (int*)ArenaAlloc(scratch, sizeof(int) * (seam_slots + 1));
+	int* seam_slot = (int*)ArenaAlloc(scratch, sizeof(int) * (seam_slots + 1)); // the merged store's slot of every kept seam triangle 
+	ok = blocked != NULL && wall_opposite != NULL && wall_edge != NULL && covered != NULL && stack != NULL && seam_slot != NULL 
+		&& InitEdgeTable(&seam_edges, 3 * seam_slots, scratch);
+
+	int stack_count = 0;
+	if (ok) {
+		memset(blocked, 0, 3 * seam_slots);
+		memset(covered, 0, seam_slots);
+		for (int i = 0; i < seam_slots; ++i) {
+			if (seam_store->state[i] != TR_LIVE) continue;
+			for (int j = 0; j < 3; ++j) {
+				int a = GlobalVertex(&seam, seam_store->vertices[3 * i + j], pt_count);
+				int b = GlobalVertex(&seam, seam_store->vertices[3 * i + (j + 1) % 3], pt_count);
+				InsertEdge(&seam_edges, a, b, 3 * i + j);
+			}
+		}
 
-		if (triangles[i].vertices[0].id >= pt_count || triangles[i].vertices[1].id >= pt_count || triangles[i].vertices[2].id >= pt_count) {
-			RemoveTriangle(tr_count, triangles, i);
-			--tr_count; 
-			--i; 
+		for (int s = 0, base = 0; s < strip_count && ok; base += strips[s].tr_count, ++s) {
+			for (int w = 0; w < strips[s].wall_count; ++w) {
+				int e = strips[s].walls[w];
+				const int* v = strips[s].triangles + 3 * (e / 3);
+				int start = v[e % 3], end = v[(e % 3 + 1) % 3];
+				int inner = FindEdge(&seam_edges, start, end);
+				int outer = FindEdge(&seam_edges, end, start);
+				if (inner == -1 || outer == -1) {
+					ok = 0;
+					break;
+				}
+				blocked[inner] = 1;
+				blocked[outer] = 1;
+				wall_opposite[outer] = v[(e % 3 + 2) % 3];
+				wall_edge[outer] = 3 * base + e;
+				if (!covered[inner / 3]) {
+					covered[inner / 3] = 1;
+					stack[stack_count++] = inner / 3;
+				}
+			}
 		}
 	}
-	
+
+	while (ok && stack_count > 0) {
+		int tr = stack[--stack_count];
+		for (int j = 0; j < 3; ++j) {
+			int o = seam_store->adjacent[3 * tr + j];
+			if (blocked[3 * tr + j] || o == -1 || covered[o]) continue;
+			covered[o] = 1;
+			stack[stack_count++] = o;
+		}
+	}
+
+	// the remaining seam triangles must be strictly Delaunay across their edges too, to the final triangles' vertices across wall edges; 
+	// they take the slots after the final triangles 
+	int seam_kept = 0;
+	for (int i = 0; ok && i < seam_slots; ++i) {
+		seam_slot[i] = -1;
+		if (seam_store->state[i] != TR_LIVE || covered[i]) continue;
+		seam_slot[i] = final_count + seam_kept++;
+
+		const int* v = seam_store->vertices + 3 * i;
+		for (int j = 0; j < 3 && ok; ++j) {
+			int o = seam_store->adjacent[3 * i + j];
+			int d = -1;
+			if (blocked[3 * i + j]) d = wall_opposite[3 * i + j];
+			else if (o == -1 || o < i) continue;
+			else for (int k = 0; k < 3; ++k) if (seam_store->adjacent[3 * o + k] == i) d = GlobalVertex(&seam, seam_store->vertices[3 * o + (k + 2) % 3], pt_count);
+			if (d == -1 || InCircle(points[GlobalVertex(&seam, v[0], pt_count)], points[GlobalVertex(&seam, v[1], pt_count)], points[GlobalVertex(&seam, v[2], pt_count)], points[d]) == 0) ok = 0;
+		}
+	}
+
+	// a triangulation of n points and the super-triangle has 2n + 1 triangles; anything else means the pieces do not fit 
+	int slot_count = final_count + seam_kept;
+	if (ok && slot_count != 2 * pt_count + 1) ok = 0;
+
+	struct TriangleStore* store = &tri->store;
+	while (ok && store->capacity < slot_count) ok = GrowTriangleStore(store);
+
+	// the final triangles, a block per strip with their links shifted by the block's first slot; their walls stay -1 until the seam is in 
+	if (ok) {
+		store->slot_count = slot_count;
+		store->free_head = -1;
+		memset(store->state, TR_LIVE, slot_count);
+		for (int s = 0, base = 0; s < strip_count; base += strips[s].tr_count, ++s) {
+			memcpy(store->vertices + 3 * base, strips[s].triangles, sizeof(int) * 3 * strips[s].tr_count);
+			const int* adjacent = strips[s].adjacent;
+			int* to = store->adjacent + 3 * base;
+			for (int k = 0; k < 3 * strips[s].tr_count; ++k) to[k] = adjacent[k] == -1 ? -1 : base + adjacent[k];
+		}
+	}
+
+	// the kept seam triangles, linked to each other through the seam's own adjacency and to the final triangles across the walls 
+	int walls_linked = 0;
+	for (int i = 0; i < seam_slots && ok; ++i) {
+		int slot = seam_slot[i];
+		if (slot == -1) continue;
+		for (int j = 0; j < 3; ++j) {
+			store->vertices[3 * slot + j] = GlobalVertex(&seam, seam_store->vertices[3 * i + j], pt_count);
+			int o = seam_store->adjacent[3 * i + j];
+			if (blocked[3 * i + j]) {
+				store->adjacent[3 * slot + j] = wall_edge[3 * i + j] / 3;
+				store->adjacent[wall_edge[3 * i + j]] = slot;
+				++walls_linked;
+			}
+			else if (o == -1) store->adjacent[3 * slot + j] = -1;
+			else if (seam_slot[o] == -1) ok = 0;
+			else store->adjacent[3 * slot + j] = seam_slot[o];
+		}
+	}
+	FreeTriangulation(&seam);
+	if (ok && walls_linked != wall_count) ok = 0;
+
+	if (ok) {
+		for (int i = 0; i < pt_count + 3; ++i) tri->vertex_triangle[i] = -1;
+		for (int i = 0; i < 3 * slot_count; ++i) tri->vertex_triangle[store->vertices[i]] = i / 3;
+		tri->last = slot_count - 1;
+	}
+
+	ResetArena(scratch);
+	return ok;
+}
+
+// Obstacle filtering stage of BowyerWatson(); returns the unique triangle edges that do not cross any obstacle, terminated by a sentinel Edge (last == 1) 
+// triangles holds three point ids per triangle, as returned by Triangulate(); does not take ownership of it 
+// the edges are tested against the obstacles through grid; the edge lookup table is allocated from scratch 
+// if rejected is not NULL, it is set to the number of edges dropped for crossing an obstacle 
+struct Edge* FilterEdges(int* triangles, int tr_count, struct Point* points, const struct ObstacleGrid* grid, struct ScratchArena* scratch, int* rejected) {
+
+	if (rejected != NULL) *rejected = 0;
+	if (triangles == NULL || tr_count == 0) return NULL;
+
 	// assemble the return array // most edges are duplicated, and are skipped using a lookup table similar to the way polygon hole edges are processed in the main loop 
+	struct PolyEdge null_edge = { -1, -1, 1 };
 	int edge_count = 0; 
 	int lookup_size = tr_count * 3;
 
-	if (tr_count == 0) {
-		free(triangles);
-		return NULL;
-	}
-
 	struct Edge* res = (struct Edge*)malloc(sizeof(struct Edge) * lookup_size + sizeof(struct Edge));
-	struct PolyEdge* lookup = (struct PolyEdge*)malloc(sizeof(struct PolyEdge) * lookup_size);
-	for (int i = 0; i < lookup_size; ++i) lookup[i] = null_edge;
+	struct ArenaMark mark = GetArenaMark(scratch);
+	struct PolyEdge* lookup = (struct PolyEdge*)ArenaAlloc(scratch, sizeof(struct PolyEdge) * lookup_size);
 
 	if (lookup == NULL || res == NULL) {
-		if (lookup != NULL) free(lookup);
+		RewindArena(scratch, mark);
 		if (res != NULL) free(res);
-		free(triangles);
 		return NULL;
 	}
 
-	printf("Removing invalid nodes...\n");
+	for (int i = 0; i < lookup_size; ++i) lookup[i] = null_edge;
 
 	for (int i = 0; i < tr_count; ++i) {
 		for (int j = 0; j < 3; ++j) {
 
-			struct PolyEdge next = triangles[i].edges[j];
+			struct PolyEdge next = { triangles[3 * i + j], triangles[3 * i + (j + 1) % 3], 0 };
 
-			int hash = next.start ^ next.end;
-			int lookup_index = ((hash << 4) + hash) % lookup_size; 
+			// the hash ignores the direction of the edge; multiplying spreads the ids of neighbouring points, whose xor alone clusters on grid-like meshes 
+			unsigned int lo = (unsigned int)(next.start < next.end ? next.start : next.end);
+			unsigned int hi = (unsigned int)(next.start < next.end ? next.end : next.start);
+			int lookup_index = (int)((lo * 2654435761u ^ hi * 40503u) % (unsigned int)lookup_size); 
 			int skip = 0; 
 			while (1) {
 				if (lookup[lookup_index].start == -1) break;
@@ -442,25 +1768,47 @@ struct Edge* BowyerWatson(int pt_count, struct Point* points, float excircle_rad
 
 			lookup[lookup_index] = next;
 
-			struct ObsEdge edge = { points[next.start], points[next.end], 0.0f, 0.0f };
-			if (!ObstacleCheck(edge, obstacles, obs_count)) continue;  
+			// tested lower id first, as NavMesh::EdgeValid() does: the segment test is not symmetric in floating point, and a moved node 
+			// must not see an edge grazing a corner differently from a full rebuild 
+			struct ObsEdge edge = { points[lo], points[hi] };
+			if (!GridObstacleCheck(grid, edge)) {
+				if (rejected != NULL) ++*rejected;
+				continue;
+			}
 
 			struct Edge res_edge = { next.start, next.end, GetWeight(points[next.start], points[next.end]), 0};
 			res[edge_count++] = res_edge;
 		}
 	}
 
-	if (edge_count == 0) printf("No valid edges remaining\n");
-
 	struct Edge last;
 	last.start = -1; 
 	last.end = -1; 
 	last.last = 1; 
 	res[edge_count] = last; // set a sentinel value for the outer scope to check if the return array is over 
 	
-	free(lookup);
-	free(triangles); 
+	RewindArena(scratch, mark);
 	
 	return res; 
 }
 
+// Triangulation algorithm 
+struct Edge* BowyerWatson(int pt_count, struct Point* points, float excircle_rad, float excircle_pos_x, float excircle_pos_y, struct Rect* obstacles, int obs_count) {
+
+	struct ScratchArena scratch;
+	InitArena(&scratch);
+	struct ObstacleGrid grid;
+	InitObstacleGrid(&grid);
+
+	int tr_count = 0;
+	int* triangles = Triangulate(pt_count, points, excircle_rad, excircle_pos_x, excircle_pos_y, &scratch, &tr_count);
+
+	struct Edge* res = NULL;
+	if (triangles != NULL && BuildObstacleGrid(&grid, obstacles, obs_count)) res = FilterEdges(triangles, tr_count, points, &grid, &scratch, NULL);
+	free(triangles);
+	FreeObstacleGrid(&grid);
+	FreeArena(&scratch);
+
+	return res;
+}
+
@@ -0,0 +1,275 @@
+#include "ContractionHierarchy.h"
+
+namespace {
+
+	const float UNREACHED = std::numeric_limits<float>::infinity();
+
+	// nodes a witness search may settle before it gives up and lets the shortcut in; a lower limit when only estimating a node's importance 
+	const int WITNESS_LIMIT = 500;
+	const int ESTIMATE_LIMIT = 50;
+
+	// an edge of the graph being contracted; middle is the node a shortcut bypasses, -1 for a mesh edge 
+	struct Arc {
+		int to;
+		float weight;
+		int middle;
+	};
+
+	// Dijkstra over the not yet contracted graph, used to find paths that make a shortcut unnecessary 
+	struct WitnessSearch {
+		Dijkstra search;
+		Stamps target;
+		std::vector<int> slot; // per target, the index of its arc from the source, if there is one 
+
+		explicit WitnessSearch(int node_count) : slot(node_count, -1) {
+			search.Reset(node_count);
+			target.Resize(node_count);
+		}
+
+		float Dist(int id) const { return search.Reached(id) ? search.Dist(id) : UNREACHED; }
+
+		// searches from source around skip, until every target is settled, or every node within max_dist is, or limit nodes are 
+		void Run(const std::vector<std::vector<Arc>>& arcs, int source, int skip, const Arc* targets, int target_count, float max_dist, int limit) {
+
+			target.Next();
+			for (int t = 0; t < target_count; ++t) {
+				target.Mark(targets[t].to);
+				slot[targets[t].to] = -1;
+			}
+			for (int k = 0; k < (int)arcs[source].size(); ++k) if (target.Current(arcs[source][k].to)) slot[arcs[source][k].to] = k;
+
+			search.Reset(arcs.size());
+			search.Relax(source, 0.0f, -1);
+			for (int settled = 0; !search.Empty() && settled < limit; ++settled) {
+				if (search.NextKey() > max_dist) break;
+
+				int u = search.Settle();
+				if (target.Current(u) && --target_count == 0) break;
+				for (const Arc& arc : arcs[u]) if (arc.to != skip) search.Relax(arc.to, search.Dist(u) + arc.weight, u);
+			}
+		}
+	};
+
+	// adds the shortcuts contracting v needs: one between two of its neighbours unless a witness path is as short as the one through v; 
+	// returns their number 
+	int Contract(std::vector<std::vector<Arc>>& arcs, int v, WitnessSearch& witness, bool estimate) {
+
+		int added = 0;
+		const std::vector<Arc>& around = arcs[v];
+		for (size_t i = 0; i < around.size(); ++i) {
+
+			// the pairs are taken once each, from their earlier end 
+			float max_dist = 0.0f;
+			for (size_t j = i + 1; j < around.size(); ++j) max_dist = std::max(max_dist, around[i].weight + around[j].weight);
+			if (i + 1 == around.size()) break;
+			witness.Run(arcs, around[i].to, v, &around[i + 1], (int)(around.size() - i - 1), max_dist, estimate ? ESTIMATE_LIMIT : WITNESS_LIMIT);
+
+			for (size_t j = i + 1; j < around.size(); ++j) {
+				int u = around[i].to, w = around[j].to;
+				float d = around[i].weight + around[j].weight;
+				if (witness.Dist(w) <= d) continue;
+				if (estimate) {
+					++added;
+					continue;
+				}
+
+				// a longer edge between the two gives way to the shortcut 
+				Arc* existing = witness.slot[w] == -1 ? nullptr : &arcs[u][witness.slot[w]];
+				if (existing != nullptr && existing->weight <= d) continue;
+				++added;
+
+				if (existing != nullptr) {
+					existing->weight = d;
+					existing->middle = v;
+					for (Arc& arc : arcs[w]) if (arc.to == u) {
+						arc.weight = d;
+						arc.middle = v;
+					}
+				}
+				else {
+					arcs[u].push_back({ w, d, v });
+					arcs[w].push_back({ u, d, v });
+				}
+			}
+		}
+		return added;
+	}
+}
+
+void ContractionHierarchy::Build(const NavMesh& mesh) {
+
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	node_count = graph.NodeCount();
+	shortcut_count = 0;
+
+	std::vector<std::vector<Arc>> arcs(node_count);
+	for (int i = 0; i < node_count; ++i) {
+		for (int k = graph.Begin(i); k < graph.End(i); ++k) arcs[i].push_back({ graph.neighbours[k], graph.weights[k], -1 });
+	}
+
+	// importance: the shortcuts contracting the node would add, less the edges it would take away, plus its neighbours already contracted 
+	// (which spreads the contraction evenly over the mesh) 
+	WitnessSearch witness(node_count);
+	std::vector<int> contracted_neighbours(node_count, 0);
+	auto importance = [&](int v) {
+		return (float)(2 * (Contract(arcs, v, witness, true) - (int)arcs[v].size()) + contracted_neighbours[v]);
+	};
+
+	std::vector<KeyedEntry> order(node_count);
+	Heap<KeyedEntry, int> queue(CompareKeyedEntries);
+	queue.Reserve(node_count);
+	for (int v = 0; v < node_count; ++v) {
+		order[v] = { v, importance(v) };
+		queue.Insert(&order[v]);
+	}
+
+	// the remaining arcs of every node when it is contracted all lead to nodes contracted later, so they are its upward edges 
+	std::vector<std::vector<Arc>> upward(node_count);
+	rank.assign(node_count, -1);
+	int next_rank = 0;
+	while (!queue.Empty()) {
+
+		// lazy updates: a node whose importance grew since it was queued goes back if it is no longer the least important; updating the 
+		// neighbours of every contracted node as well was measured to cost five times the build for a few percent fewer shortcuts 
+		KeyedEntry* top = queue.RemoveRoot();
+		int v = top->ID;
+		float current = importance(v);
+		if (!queue.Empty() && current > queue.GetRoot()->key) {
+			top->key = current;
+			queue.Insert(top);
+			continue;
+		}
+
+		rank[v] = next_rank++;
+		shortcut_count += Contract(arcs, v, witness, false);
+
+		for (const Arc& arc : arcs[v]) {
+			std::vector<Arc>& back = arcs[arc.to];
+			for (size_t k = 0; k < back.size(); ++k) {
+				if (back[k].to != v) continue;
+				back[k] = back.back();
+				back.pop_back();
+				break;
+			}
+			++contracted_neighbours[arc.to];
+		}
+		upward[v].swap(arcs[v]);
+	}
+
+	offsets.assign(node_count + 1, 0);
+	targets.clear();
+	weights.clear();
+	middles.clear();
+	for (int v = 0; v < node_count; ++v) {
+		for (const Arc& arc : upward[v]) {
+			targets.push_back(arc.to);
+			weights.push_back(arc.weight);
+			middles.push_back(arc.middle);
+		}
+		offsets[v + 1] = (int)targets.size();
+	}
+}
+
+
+int ContractionHierarchy::FindEdge(int from, int to) const {
+	for (int k = offsets[from]; k < offsets[from + 1]; ++k) if (targets[k] == to) return k;
+	return -1;
+}
+
+void ContractionHierarchy::Unpack(int x, int y, int k, std::vector<int>& path) const {
+
+	// a shortcut (x, y) over m stands for the edges (m, x) and (m, y), both stored at m, which was contracted before either end 
+	struct Hop { int from, to, edge; };
+	std::vector<Hop> stack = { { x, y, k } };
+	while (!stack.empty()) {
+		Hop hop = stack.back();
+		stack.pop_back();
+
+		int m = middles[hop.edge];
+		if (m == -1) {
+			path.push_back(hop.to);
+			continue;
+		}
+		stack.push_back({ m, hop.to, FindEdge(m, hop.to) });
+		stack.push_back({ hop.from, m, FindEdge(m, hop.from) });
+	}
+}
+
+
+size_t ContractionHierarchy::GetMemoryUsage() const {
+	return sizeof(int) * (rank.size() + offsets.size() + targets.size() + middles.size()) + sizeof(float) * weights.size();
+}
+
+
+void ContractionHierarchy::SearchContext::Reset(int node_count) {
+
+	for (Side& side : sides) {
+		side.search.Reset(node_count);
+		if ((int)side.parent_edge.size() < node_count) side.parent_edge.resize(node_count);
+	}
+	stats = Stats();
+}
+
+std::vector<int> ContractionHierarchy::Find(int start_id, int destination_id, SearchContext& context) const {
+
+	std::vector<int> path;
+	context.Reset(node_count);
+	if (start_id == destination_id) {
+		path.push_back(start_id);
+		return path;
+	}
+
+	typedef SearchContext::Side Side;
+	auto reach = [&](Side& side, int id, float d, int from, int edge) {
+		if (side.search.Relax(id, d, from)) side.parent_edge[id] = edge;
+	};
+
+	Side& forward = context.sides[0];
+	Side& backward = context.sides[1];
+	reach(forward, start_id, 0.0f, -1, -1);
+	reach(backward, destination_id, 0.0f, -1, -1);
+
+	// both searches only climb, and the shortest path's highest node is settled by both; a side stops once it can no longer beat the best 
+	// meeting found so far 
+	float best = UNREACHED;
+	int meet = -1;
+	for (;;) {
+		float forward_key = forward.search.NextKey();
+		float backward_key = backward.search.NextKey();
+		if (std::min(forward_key, backward_key) >= best) break;
+
+		int s = forward_key <= backward_key ? 0 : 1;
+		Side& side = context.sides[s];
+		const Side& other = context.sides[1 - s];
+
+		int u = side.search.Settle();
+		++context.stats.expanded;
+		float d = side.search.Dist(u);
+		if (other.search.Reached(u) && d + other.search.Dist(u) < best) {
+			best = d + other.search.Dist(u);
+			meet = u;
+		}
+
+		// stall on demand: a node reached more cheaply through a higher one it links to is not on a shortest upward path, and neither is 
+		// anything searched from it 
+		bool stalled = false;
+		for (int k = offsets[u]; k < offsets[u + 1] && !stalled; ++k) {
+			int x = targets[k];
+			stalled = side.search.Reached(x) && side.search.Dist(x) + weights[k] < d;
+		}
+		if (stalled) continue;
+
+		for (int k = offsets[u]; k < offsets[u + 1]; ++k) reach(side, targets[k], d + weights[k], u, k);
+	}
+	if (meet == -1) return path;
+
+	// up from the start to the meeting node, then down to the destination 
+	std::vector<int> climb;
+	for (int id = meet; id != -1; id = forward.search.Parent(id)) climb.push_back(id);
+	path.push_back(start_id);
+	for (size_t i = climb.size() - 1; i > 0; --i) Unpack(climb[i], climb[i - 1], forward.parent_edge[climb[i - 1]], path);
+	for (int id = meet; id != destination_id; id = backward.search.Parent(id)) Unpack(id, backward.search.Parent(id), backward.parent_edge[id], path);
+
+	context.stats.cost = best;
+	return path;
+}
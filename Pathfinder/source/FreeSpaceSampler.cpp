@@ -0,0 +1,224 @@
+#include "FreeSpaceSampler.h"
+
+namespace {
+
+	// the cells an obstacle touches and the cells it covers entirely; either range is empty if first > last 
+	// the obstacle is grown by EDGE_MARGIN of a cell for the first and shrunk by it for the second, far more than the rounding of a point 
+	// drawn in a cell could carry it across the cell's border, so that a cell is only taken for free or blocked if it certainly is 
+	struct CellRange {
+		int c0, r0, c1, r1;
+		bool Contains(int c, int r) const { return c >= c0 && c <= c1 && r >= r0 && r <= r1; }
+		bool Empty() const { return c0 > c1 || r0 > r1; }
+	};
+
+	// v, already rounded, as an int a few cells past the ends of a row or column of n at most, so that far off obstacles cannot overflow it 
+	int ClampCell(double v, int n) { return (int)std::max(-4.0, std::min((double)n + 4.0, v)); }
+
+	const double EDGE_MARGIN = 0.01;
+}
+
+FreeSpaceSampler::FreeSpaceSampler(int sc_w, int sc_h, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles, float clearance, int cell_target)
+	: width((float)sc_w), height((float)sc_h), clearance(clearance) {
+
+	if (sc_w <= 0 || sc_h <= 0) return;
+
+	// grown by the clearance exactly as the obstacle grid's point test does, so that both agree to the last bit 
+	for (const std::pair<sf::Vector2f, sf::Vector2f>& obs : obstacles) {
+		sf::Vector2f far_corner = obs.first + obs.second;
+		bounds.push_back(std::min(obs.first.x, far_corner.x) - clearance);
+		bounds.push_back(std::min(obs.first.y, far_corner.y) - clearance);
+		bounds.push_back(std::max(obs.first.x, far_corner.x) + clearance);
+		bounds.push_back(std::max(obs.first.y, far_corner.y) + clearance);
+	}
+
+	// square cells, as near as the area allows 
+	cell_target = std::max(1, cell_target);
+	cols = std::max(1, (int)std::lround(std::sqrt((double)cell_target * width / height)));
+	rows = std::max(1, (int)std::lround((double)cell_target / cols));
+	cell_w = width / cols;
+	cell_h = height / rows;
+
+	int obs_count = (int)obstacles.size();
+	std::vector<CellRange> touched(obs_count);
+	std::vector<CellRange> covered(obs_count);
+	for (int i = 0; i < obs_count; ++i) {
+		const float* b = &bounds[4 * (size_t)i];
+		double x0 = b[0] / cell_w, y0 = b[1] / cell_h, x1 = b[2] / cell_w, y1 = b[3] / cell_h;
+
+		touched[i] = { std::max(0, ClampCell(std::floor(x0 - EDGE_MARGIN), cols)), std::max(0, ClampCell(std::floor(y0 - EDGE_MARGIN), rows)),
+			std::min(cols - 1, ClampCell(std::floor(x1 + EDGE_MARGIN), cols)), std::min(rows - 1, ClampCell(std::floor(y1 + EDGE_MARGIN), rows)) };
+		covered[i] = { std::max(0, ClampCell(std::ceil(x0 + EDGE_MARGIN), cols)), std::max(0, ClampCell(std::ceil(y0 + EDGE_MARGIN), rows)),
+			std::min(cols - 1, ClampCell(std::floor(x1 - EDGE_MARGIN), cols) - 1), std::min(rows - 1, ClampCell(std::floor(y1 - EDGE_MARGIN), rows) - 1) };
+		if (touched[i].Empty()) covered[i] = touched[i];
+	}
+
+	// count the touching and covering obstacles of every cell with two difference arrays, so that large obstacles cost no more than small ones 
+	std::vector<int> touch_count((size_t)(cols + 1) * (rows + 1), 0);
+	std::vector<int> cover_count((size_t)(cols + 1) * (rows + 1), 0);
+	auto mark = [&](std::vector<int>& counts, const CellRange& range) {
+		if (range.Empty()) return;
+		++counts[(size_t)range.r0 * (cols + 1) + range.c0];
+		--counts[(size_t)range.r0 * (cols + 1) + range.c1 + 1];
+		--counts[(size_t)(range.r1 + 1) * (cols + 1) + range.c0];
+		++counts[(size_t)(range.r1 + 1) * (cols + 1) + range.c1 + 1];
+	};
+	for (int i = 0; i < obs_count; ++i) {
+		mark(touch_count, touched[i]);
+		mark(cover_count, covered[i]);
+	}
+	for (std::vector<int>* counts : { &touch_count, &cover_count }) {
+		std::vector<int>& sum = *counts;
+		for (int r = 0; r <= rows; ++r) {
+			for (int c = 0; c <= cols; ++c) {
+				size_t k = (size_t)r * (cols + 1) + c;
+				if (c > 0) sum[k] += sum[k - 1];
+				if (r > 0) sum[k] += sum[k - (cols + 1)];
+				if (c > 0 && r > 0) sum[k] -= sum[k - (cols + 1) - 1];
+			}
+		}
+	}
+
+	cells.resize((size_t)cols * rows);
+	for (int r = 0; r < rows; ++r) {
+		for (int c = 0; c < cols; ++c) {
+			size_t k = (size_t)r * (cols + 1) + c;
+			int cell = r * cols + c;
+			cells[cell] = cover_count[k] > 0 ? BLOCKED : touch_count[k] > 0 ? PARTIAL : FREE;
+			if (cells[cell] == BLOCKED) continue;
+			candidates.push_back(cell);
+			if (cells[cell] == FREE) ++free_cells;
+		}
+	}
+
+	// list the obstacles of the partly covered cells; a cell an obstacle covers entirely is blocked, so only the ring of touched cells 
+	// around the covered ones is walked, and the lists take time in proportion to the obstacle outlines 
+	obstacle_start.assign(cells.size() + 1, 0);
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int i = 0; i < obs_count; ++i) {
+			const CellRange& ring = touched[i];
+			for (int r = ring.r0; r <= ring.r1; ++r) {
+				for (int c = ring.c0; c <= ring.c1; ++c) {
+					if (covered[i].Contains(c, r)) {
+						c = covered[i].c1;
+						continue;
+					}
+					int cell = r * cols + c;
+					if (cells[cell] != PARTIAL) continue;
+					if (pass == 0) ++obstacle_start[cell + 1];
+					else obstacle_items[obstacle_start[cell]++] = i;
+				}
+			}
+		}
+
+		if (pass == 0) {
+			for (size_t c = 0; c < cells.size(); ++c) obstacle_start[c + 1] += obstacle_start[c];
+			obstacle_items.resize(obstacle_start.back());
+		}
+	}
+
+	// filling advanced every cell's start to the next cell's, so shift them back 
+	for (size_t c = cells.size(); c > 0; --c) obstacle_start[c] = obstacle_start[c - 1];
+	obstacle_start[0] = 0;
+}
+
+
+bool FreeSpaceSampler::Blocked(sf::Vector2f pt, int cell) const {
+
+	if (cells[cell] != PARTIAL) return cells[cell] == BLOCKED;
+
+	for (int k = obstacle_start[cell]; k < obstacle_start[cell + 1]; ++k) {
+		const float* b = &bounds[4 * (size_t)obstacle_items[k]];
+		if (pt.x >= b[0] && pt.x <= b[2] && pt.y >= b[1] && pt.y <= b[3]) return true;
+	}
+	return false;
+}
+
+bool FreeSpaceSampler::Blocked(sf::Vector2f pt) const {
+
+	if (cells.empty() || !(pt.x >= 0.0f && pt.x <= width && pt.y >= 0.0f && pt.y <= height)) return true;
+
+	int c = std::min(cols - 1, (int)(pt.x / cell_w));
+	int r = std::min(rows - 1, (int)(pt.y / cell_h));
+	return Blocked(pt, r * cols + c);
+}
+
+bool FreeSpaceSampler::Sample(std::mt19937& gen, sf::Vector2f& pt) const {
+
+	if (candidates.empty()) return false;
+
+	std::uniform_int_distribution<int> pick(0, (int)candidates.size() - 1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	for (int attempt = 0; attempt < ATTEMPTS_PER_POINT; ++attempt) {
+		++stats.attempts;
+
+		int cell = candidates[pick(gen)];
+		int c = cell % cols;
+		int r = cell / cols;
+		pt = sf::Vector2f((c + unit(gen)) * cell_w, (r + unit(gen)) * cell_h);
+
+		// only a partly covered cell can hold a blocked point 
+		if (cells[cell] == PARTIAL && Blocked(pt, cell)) {
+			++stats.rejected_obstacle;
+			continue;
+		}
+		return true;
+	}
+	return false;
+}
+
+std::vector<sf::Vector2f> FreeSpaceSampler::Sample(std::mt19937& gen, int count, float min_spacing) const {
+
+	std::vector<sf::Vector2f> points;
+	if (count <= 0 || candidates.empty()) return points;
+	points.reserve(count);
+
+	long long budget = (long long)count * ATTEMPTS_PER_POINT;
+	long long start = stats.attempts;
+	sf::Vector2f pt;
+
+	if (min_spacing <= 0.0f) {
+		while ((int)points.size() < count && stats.attempts - start < budget) {
+			if (Sample(gen, pt)) points.push_back(pt);
+		}
+		return points;
+	}
+
+	// the points taken so far, in a grid of cells no smaller than the spacing (and no more cells than points), so that a point can only be 
+	// too close to the points of its own and the eight surrounding cells 
+	float side = std::max(min_spacing, std::sqrt(width * height / count));
+	int grid_cols = std::max(1, (int)std::ceil(width / side));
+	int grid_rows = std::max(1, (int)std::ceil(height / side));
+	std::vector<int> head((size_t)grid_cols * grid_rows, -1);
+	std::vector<int> next;
+	next.reserve(count);
+	float spacing_sq = min_spacing * min_spacing;
+
+	while ((int)points.size() < count && stats.attempts - start < budget) {
+		if (!Sample(gen, pt)) continue;
+
+		int gc = std::min(grid_cols - 1, (int)(pt.x / side));
+		int gr = std::min(grid_rows - 1, (int)(pt.y / side));
+		bool clear = true;
+		for (int r = std::max(0, gr - 1); clear && r <= std::min(grid_rows - 1, gr + 1); ++r) {
+			for (int c = std::max(0, gc - 1); clear && c <= std::min(grid_cols - 1, gc + 1); ++c) {
+				for (int k = head[(size_t)r * grid_cols + c]; k != -1; k = next[k]) {
+					sf::Vector2f d = points[k] - pt;
+					if (d.x * d.x + d.y * d.y < spacing_sq) {
+						clear = false;
+						break;
+					}
+				}
+			}
+		}
+		if (!clear) {
+			++stats.rejected_spacing;
+			continue;
+		}
+
+		next.push_back(head[(size_t)gr * grid_cols + gc]);
+		head[(size_t)gr * grid_cols + gc] = (int)points.size();
+		points.push_back(pt);
+	}
+	return points;
+}
@@ -0,0 +1,457 @@
+#include "HPAStar.h"
+
+#include <cstring> // memcpy, to hash float bits 
+#include <limits>
+
+namespace {
+
+	const float UNREACHED = std::numeric_limits<float>::infinity();
+
+	// a run of the edges joining two regions longer than this gets a portal near each end rather than one in the middle 
+	const int LONG_RUN = 8;
+
+	unsigned long long Mix(unsigned long long h, unsigned long long v) {
+		h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+		return h * 0xff51afd7ed558ccdull;
+	}
+
+	unsigned long long FloatBits(float f) {
+		unsigned int bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+
+	// an edge between two regions, as both of them see it 
+	struct Crossing {
+		int lo, hi; // mesh ids 
+		float weight;
+		float along; // position of the midpoint along the regions' border 
+	};
+}
+
+
+int HPA_Star::CellOf(sf::Vector2f pos) const {
+	int x = (int)((pos.x - min_x) / cell_w);
+	int y = (int)((pos.y - min_y) / cell_h);
+	x = x < 0 ? 0 : x >= cells_x ? cells_x - 1 : x;
+	y = y < 0 ? 0 : y >= cells_y ? cells_y - 1 : y;
+	return y * cells_x + x;
+}
+
+unsigned long long HPA_Star::Fingerprint(const NavMesh::Graph& graph, const std::vector<int>& nodes) const {
+	unsigned long long h = nodes.size();
+	for (int id : nodes) {
+		h = Mix(h, (unsigned long long)id);
+		h = Mix(h, FloatBits(graph.xs[id]) << 32 | FloatBits(graph.ys[id]));
+
+		// MoveNode() may leave a row in a different order than Remake() would, so its edges are summed rather than chained 
+		unsigned long long row = 0;
+		for (int k = graph.Begin(id); k < graph.End(id); ++k) row += Mix(0, (unsigned long long)graph.neighbours[k] << 32 | FloatBits(graph.weights[k]));
+		h = Mix(h, row);
+	}
+	return h;
+}
+
+
+void HPA_Star::Build(const NavMesh& mesh) {
+	node_count = -1;
+	Update(mesh);
+}
+
+int HPA_Star::Update(const NavMesh& mesh) {
+
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	int n = graph.NodeCount();
+	bool full = n != node_count;
+
+	// a new grid, sized for about cluster_nodes nodes per cell 
+	if (full) {
+		node_count = n;
+		float max_x = 0.0f, max_y = 0.0f;
+		min_x = min_y = 0.0f;
+		if (n > 0) {
+			min_x = *std::min_element(graph.xs.begin(), graph.xs.end());
+			max_x = *std::max_element(graph.xs.begin(), graph.xs.end());
+			min_y = *std::min_element(graph.ys.begin(), graph.ys.end());
+			max_y = *std::max_element(graph.ys.begin(), graph.ys.end());
+		}
+		float w = std::max(max_x - min_x, 1.0f), h = std::max(max_y - min_y, 1.0f);
+		float side = std::sqrt(w * h * cluster_nodes / std::max(n, 1));
+		cells_x = std::max(1, (int)std::ceil(w / side));
+		cells_y = std::max(1, (int)std::ceil(h / side));
+		cell_w = w / cells_x * 1.0001f; // the nodes on the far edges stay inside the last cells 
+		cell_h = h / cells_y * 1.0001f;
+
+		clusters.assign(cells_x * cells_y, Cluster());
+		node_cluster.assign(n, -1);
+		node_region.assign(n, -1);
+		node_local.assign(n, -1);
+	}
+
+	// regroup the nodes, as MoveNode() may have carried some across cells 
+	std::vector<std::vector<int>> members(clusters.size());
+	for (int i = 0; i < n; ++i) members[CellOf(graph.Position(i))].push_back(i);
+
+	std::vector<char> changed(clusters.size(), 0);
+	for (int c = 0; c < (int)clusters.size(); ++c) {
+		unsigned long long fingerprint = Fingerprint(graph, members[c]);
+		if (full || fingerprint != clusters[c].fingerprint || members[c] != clusters[c].nodes) {
+			changed[c] = 1;
+			clusters[c].nodes.swap(members[c]);
+			clusters[c].fingerprint = fingerprint;
+		}
+	}
+	for (int c = 0; c < (int)clusters.size(); ++c) if (changed[c]) for (int id : clusters[c].nodes) node_cluster[id] = c;
+	for (int c = 0; c < (int)clusters.size(); ++c) if (changed[c]) LabelRegions(graph, c);
+
+	// a changed cluster's neighbours, before and after, pick their portals towards it again 
+	std::vector<char> dirty(changed);
+	for (int c = 0; c < (int)clusters.size(); ++c) {
+		if (!changed[c]) continue;
+		for (int other : clusters[c].neighbours) dirty[other] = 1;
+		for (int id : clusters[c].nodes) {
+			for (int k = graph.Begin(id); k < graph.End(id); ++k) dirty[node_cluster[graph.neighbours[k]]] = 1;
+		}
+	}
+
+	int rebuilt = 0;
+	for (int c = 0; c < (int)clusters.size(); ++c) {
+		if (!dirty[c]) continue;
+		BuildRegions(graph, c);
+		++rebuilt;
+	}
+	if (rebuilt > 0) BuildAbstractGraph(graph);
+
+	return rebuilt;
+}
+
+
+void HPA_Star::LabelRegions(const NavMesh::Graph& graph, int c) {
+
+	Cluster& cluster = clusters[c];
+	cluster.regions.clear();
+
+	// flood fill over the edges that stay inside the cluster; nodes are visited in id order, so each region's list comes out ascending 
+	std::vector<int> stack;
+	for (int id : cluster.nodes) node_region[id] = -1;
+	for (int seed : cluster.nodes) {
+		if (node_region[seed] != -1) continue;
+
+		int r = (int)cluster.regions.size();
+		cluster.regions.emplace_back();
+		node_region[seed] = r;
+		stack.push_back(seed);
+		while (!stack.empty()) {
+			int u = stack.back();
+			stack.pop_back();
+			cluster.regions[r].nodes.push_back(u);
+			for (int k = graph.Begin(u); k < graph.End(u); ++k) {
+				int w = graph.neighbours[k];
+				if (node_cluster[w] != c || node_region[w] != -1) continue;
+				node_region[w] = r;
+				stack.push_back(w);
+			}
+		}
+		std::sort(cluster.regions[r].nodes.begin(), cluster.regions[r].nodes.end());
+	}
+
+	for (Region& region : cluster.regions) {
+		for (int i = 0; i < (int)region.nodes.size(); ++i) node_local[region.nodes[i]] = i;
+	}
+
+	// copy the edges inside each region out of the mesh graph, so that searching it reads nothing else 
+	for (int r = 0; r < (int)cluster.regions.size(); ++r) {
+		Region& region = cluster.regions[r];
+		region.offsets.assign(1, 0);
+		region.neighbours.clear();
+		region.weights.clear();
+		for (int u : region.nodes) {
+			for (int k = graph.Begin(u); k < graph.End(u); ++k) {
+				int w = graph.neighbours[k];
+				if (node_cluster[w] != c || node_region[w] != r) continue;
+				region.neighbours.push_back(node_local[w]);
+				region.weights.push_back(graph.weights[k]);
+			}
+			region.offsets.push_back((int)region.neighbours.size());
+		}
+	}
+}
+
+
+void HPA_Star::BuildRegions(const NavMesh::Graph& graph, int c) {
+
+	Cluster& cluster = clusters[c];
+	cluster.neighbours.clear();
+
+	for (int r = 0; r < (int)cluster.regions.size(); ++r) {
+
+		Region& region = cluster.regions[r];
+		region.portals.clear();
+		region.links.clear();
+
+		// the edges leaving the region, grouped by the region they lead to 
+		std::vector<std::pair<std::pair<int, int>, Crossing>> crossings;
+		for (int u : region.nodes) {
+			for (int k = graph.Begin(u); k < graph.End(u); ++k) {
+				int w = graph.neighbours[k];
+				if (node_cluster[w] == c && node_region[w] == r) continue;
+				crossings.push_back({ { node_cluster[w], node_region[w] }, { std::min(u, w), std::max(u, w), graph.weights[k], 0.0f } });
+				if (node_cluster[w] != c) cluster.neighbours.push_back(node_cluster[w]);
+			}
+		}
+		std::sort(crossings.begin(), crossings.end(), [](const std::pair<std::pair<int, int>, Crossing>& a, const std::pair<std::pair<int, int>, Crossing>& b) {
+			return a.first < b.first || (a.first == b.first && (a.second.lo < b.second.lo || (a.second.lo == b.second.lo && a.second.hi < b.second.hi)));
+		});
+
+		// each group is split into runs of edges along the border, broken where an obstacle leaves a gap, and the runs get their portals 
+		// the choice depends only on the group's edges, in (lo, hi) order, so the region on the other side makes the same one 
+		std::vector<Crossing> group;
+		std::vector<int> picked; // mesh ids of this region's ends of the picked edges 
+		for (size_t first = 0; first < crossings.size();) {
+
+			size_t last = first;
+			group.clear();
+			while (last < crossings.size() && crossings[last].first == crossings[first].first) group.push_back(crossings[last++].second);
+
+			float lo_x = UNREACHED, lo_y = UNREACHED, hi_x = -UNREACHED, hi_y = -UNREACHED, length = 0.0f;
+			for (Crossing& e : group) {
+				sf::Vector2f mid = (graph.Position(e.lo) + graph.Position(e.hi)) * 0.5f;
+				lo_x = std::min(lo_x, mid.x);
+				hi_x = std::max(hi_x, mid.x);
+				lo_y = std::min(lo_y, mid.y);
+				hi_y = std::max(hi_y, mid.y);
+				length += e.weight;
+			}
+			bool along_x = hi_x - lo_x >= hi_y - lo_y;
+			for (Crossing& e : group) {
+				sf::Vector2f mid = (graph.Position(e.lo) + graph.Position(e.hi)) * 0.5f;
+				e.along = along_x ? mid.x : mid.y;
+			}
+			std::stable_sort(group.begin(), group.end(), [](const Crossing& a, const Crossing& b) { return a.along < b.along; });
+
+			float gap = 2.0f * length / group.size();
+			for (size_t run = 0; run < group.size();) {
+				size_t end = run + 1;
+				while (end < group.size() && group[end].along - group[end - 1].along <= gap) ++end;
+
+				int count = (int)(end - run);
+				int picks[2] = { count / 2, -1 };
+				if (count > LONG_RUN) {
+					picks[0] = count / 4;
+					picks[1] = count - 1 - count / 4;
+				}
+				for (int p : picks) {
+					if (p < 0) continue;
+					const Crossing& e = group[run + p];
+					int own = node_cluster[e.lo] == c && node_region[e.lo] == r ? e.lo : e.hi;
+					region.links.push_back({ own, own == e.lo ? e.hi : e.lo, e.weight }); // portal holds the mesh id until numbered below 
+					picked.push_back(own);
+				}
+				run = end;
+			}
+			first = last;
+		}
+
+		// number the portals, ascending by local index 
+		std::sort(picked.begin(), picked.end());
+		picked.erase(std::unique(picked.begin(), picked.end()), picked.end());
+		for (int id : picked) region.portals.push_back(node_local[id]);
+		for (Link& link : region.links) link.portal = (int)(std::lower_bound(picked.begin(), picked.end(), link.portal) - picked.begin());
+
+		// a shortest path tree per portal, kept for expanding paths, and the portal to portal distances off it 
+		int size = (int)region.nodes.size();
+		int portal_count = (int)region.portals.size();
+		region.distances.assign((size_t)portal_count * portal_count, 0.0f);
+		region.parents.resize((size_t)portal_count * size);
+		for (int p = 0; p < portal_count; ++p) {
+			SearchRegion(region, region.portals[p], search);
+			int* tree = region.parents.data() + (size_t)p * size;
+			for (int v = 0; v < size; ++v) tree[v] = search.Reached(v) ? search.Parent(v) : -1;
+			for (int q = 0; q < portal_count; ++q) {
+				int v = region.portals[q];
+				region.distances[(size_t)p * portal_count + q] = search.Reached(v) ? search.Dist(v) : UNREACHED;
+			}
+		}
+	}
+
+	std::sort(cluster.neighbours.begin(), cluster.neighbours.end());
+	cluster.neighbours.erase(std::unique(cluster.neighbours.begin(), cluster.neighbours.end()), cluster.neighbours.end());
+}
+
+
+void HPA_Star::SearchRegion(const Region& region, int root, Dijkstra& search) {
+	search.Reset(region.nodes.size());
+	search.Relax(root, 0.0f, -1);
+	search.Run(region.offsets.data(), region.neighbours.data(), region.weights.data());
+}
+
+
+void HPA_Star::BuildAbstractGraph(const NavMesh::Graph& graph) {
+
+	abstract_of.assign(node_count, -1);
+	abstract_node.clear();
+	abstract_xs.clear();
+	abstract_ys.clear();
+	for (const Cluster& cluster : clusters) {
+		for (const Region& region : cluster.regions) {
+			for (int p : region.portals) {
+				abstract_of[region.nodes[p]] = (int)abstract_node.size();
+				abstract_node.push_back(region.nodes[p]);
+				abstract_xs.push_back(graph.xs[region.nodes[p]]);
+				abstract_ys.push_back(graph.ys[region.nodes[p]]);
+			}
+		}
+	}
+
+	// every portal links to the others of its region, and across its picked edges 
+	offsets.assign(abstract_node.size() + 1, 0);
+	targets.clear();
+	weights.clear();
+	for (const Cluster& cluster : clusters) {
+		for (const Region& region : cluster.regions) {
+
+			int portal_count = (int)region.portals.size();
+			for (int p = 0; p < portal_count; ++p) {
+				for (int q = 0; q < portal_count; ++q) {
+					if (q == p) continue;
+					targets.push_back(abstract_of[region.nodes[region.portals[q]]]);
+					weights.push_back(region.distances[(size_t)p * portal_count + q]);
+				}
+				for (const Link& link : region.links) {
+					if (link.portal != p) continue;
+					targets.push_back(abstract_of[link.node]);
+					weights.push_back(link.weight);
+				}
+				offsets[abstract_of[region.nodes[region.portals[p]]] + 1] = (int)targets.size();
+			}
+		}
+	}
+}
+
+
+size_t HPA_Star::GetMemoryUsage() const {
+
+	size_t bytes = sizeof(int) * (node_cluster.size() + node_region.size() + node_local.size() + abstract_of.size() + abstract_node.size())
+		+ sizeof(int) * (offsets.size() + targets.size()) + sizeof(float) * weights.size();
+	for (const Cluster& cluster : clusters) {
+		bytes += sizeof(Cluster) + sizeof(int) * (cluster.nodes.size() + cluster.neighbours.size());
+		for (const Region& region : cluster.regions) {
+			bytes += sizeof(Region) + sizeof(int) * (region.nodes.size() + region.portals.size() + region.parents.size())
+				+ sizeof(Link) * region.links.size() + sizeof(float) * region.distances.size();
+			bytes += sizeof(int) * (region.offsets.size() + region.neighbours.size()) + sizeof(float) * region.weights.size();
+		}
+	}
+	return bytes;
+}
+
+
+void HPA_Star::SearchContext::Reset(int abstract_count) {
+
+	// the start and the destination sit after the portals 
+	search.Reset(abstract_count + 2);
+	stats = Stats();
+}
+
+std::vector<int> HPA_Star::Find(const NavMesh& mesh, int start_id, int destination_id, SearchContext& context) const {
+
+	std::vector<int> path;
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	int abstract_count = (int)abstract_node.size();
+	context.Reset(abstract_count);
+	if (graph.NodeCount() != node_count) return path;
+
+	if (start_id == destination_id) {
+		path.push_back(start_id);
+		return path;
+	}
+
+	// the start and the destination join the abstract graph through the distances to their regions' portals 
+	int start_c = node_cluster[start_id], start_r = node_region[start_id];
+	int dest_c = node_cluster[destination_id], dest_r = node_region[destination_id];
+	const Region& start_region = clusters[start_c].regions[start_r];
+	const Region& dest_region = clusters[dest_c].regions[dest_r];
+	bool same_region = start_c == dest_c && start_r == dest_r;
+
+	const Dijkstra& from_start = context.start_search;
+	const Dijkstra& to_destination = context.destination_search;
+	SearchRegion(start_region, node_local[start_id], context.start_search);
+	SearchRegion(dest_region, node_local[destination_id], context.destination_search);
+
+	const int start = abstract_count, goal = abstract_count + 1;
+	sf::Vector2f destination_pos = graph.Position(destination_id);
+
+	auto position = [&](int a) { return a == start ? graph.Position(start_id) : a == goal ? destination_pos : sf::Vector2f(abstract_xs[a], abstract_ys[a]); };
+
+	// A* over the portals: the context's Dijkstra, queued by g plus the straight-line distance; the check up front spares the square root 
+	Dijkstra& search = context.search;
+	auto relax = [&](int a, int from, float g) {
+		if (search.Reached(a) && g >= search.Dist(a)) return;
+
+		sf::Vector2f to_dest = position(a) - destination_pos;
+		search.Relax(a, g, from, g + std::sqrt(to_dest.x * to_dest.x + to_dest.y * to_dest.y));
+	};
+
+	relax(start, -1, 0.0f);
+	bool found = false;
+	while (!search.Empty()) {
+
+		int a = search.Settle();
+		++context.stats.expanded;
+		if (a == goal) {
+			found = true;
+			break;
+		}
+
+		float g = search.Dist(a);
+		if (a == start) {
+			for (int p : start_region.portals) if (from_start.Reached(p)) relax(abstract_of[start_region.nodes[p]], start, g + from_start.Dist(p));
+			if (same_region && from_start.Reached(node_local[destination_id])) relax(goal, start, g + from_start.Dist(node_local[destination_id]));
+			continue;
+		}
+
+		for (int k = offsets[a]; k < offsets[a + 1]; ++k) relax(targets[k], a, g + weights[k]);
+
+		// a portal of the destination's region reaches it directly 
+		int id = abstract_node[a];
+		if (node_cluster[id] == dest_c && node_region[id] == dest_r && to_destination.Reached(node_local[id])) relax(goal, a, g + to_destination.Dist(node_local[id]));
+	}
+	if (!found) return path;
+
+	// expand the hops into mesh paths, walking back from the goal 
+	std::vector<int> hops;
+	for (int a = goal; a != -1; a = search.Parent(a)) hops.push_back(a);
+	std::reverse(hops.begin(), hops.end());
+
+	path.push_back(start_id);
+	for (size_t h = 1; h < hops.size(); ++h) {
+
+		int from = hops[h - 1], to = hops[h];
+		if (from == start) {
+
+			// the start's tree points back to the start, so the walk comes out reversed 
+			int end = to == goal ? node_local[destination_id] : node_local[abstract_node[to]];
+			size_t mark = path.size();
+			for (int v = end; v != node_local[start_id]; v = from_start.Parent(v)) path.push_back(start_region.nodes[v]);
+			std::reverse(path.begin() + mark, path.end());
+		}
+		else if (to == goal) {
+			for (int v = to_destination.Parent(node_local[abstract_node[from]]); v != -1; v = to_destination.Parent(v)) path.push_back(dest_region.nodes[v]);
+		}
+		else {
+			int u = abstract_node[from], w = abstract_node[to];
+			if (node_cluster[u] != node_cluster[w] || node_region[u] != node_region[w]) path.push_back(w); // a picked edge 
+			else {
+
+				// down the tree of the far portal, which leads to it from anywhere in the region 
+				const Region& region = clusters[node_cluster[u]].regions[node_region[u]];
+				int size = (int)region.nodes.size();
+				int q = (int)(std::lower_bound(region.portals.begin(), region.portals.end(), node_local[w]) - region.portals.begin());
+				const int* tree = region.parents.data() + (size_t)q * size;
+				for (int v = tree[node_local[u]]; v != -1; v = tree[v]) path.push_back(region.nodes[v]);
+			}
+		}
+	}
+
+	context.stats.cost = search.Dist(goal);
+	return path;
+}
@@ -20,8 +20,7 @@ void Interface::Update(sf::RenderWindow& win) {
         case 1:
             SetMeshSize();
             nav_mesh = new NavMesh(win.getSize().x, win.getSize().y, mesh_size, GetObstacleData()); 
-            GetNodesInterface();
-            GetEdgeDisplay();
+            renderer.Build(*nav_mesh);
 
             std::cout << "Left-click on a red node to set the start node\nRight-click on a red node to set the destination\n"; 
             std::cout << "If start/destination is not selected, it will be selected randomly\nPress D and left-click to drag a node and adjust the mesh\n";
@@ -33,7 +32,6 @@ void Interface::Update(sf::RenderWindow& win) {
             if (!nav_mesh->EndSelected()) nav_mesh->RandomEnd();
          
             GetPath(A_Star::Find(*nav_mesh));
-            GetEdgeDisplay();
 
             std::cout << "Press SPACE to re-generate the obstacles\n\n";
             break;
@@ -52,46 +50,32 @@ void Interface::Update(sf::RenderWindow& win) {
     
     // drawing 
     for (const Obstacle& obs: obstacles) win.draw(obs.shape);
-    win.draw(edges.data(), (int)edges.size(), sf::Lines);
     UpdateNodes(win);
 }
 
 void Interface::UpdateNodes(sf::RenderWindow& win) {
 
-    int index = 0; 
-    for (Node& node : nodes) {
+    // the node under the mouse, looked up in the mesh's node grid instead of testing every node 
+    sf::Vector2f mouse_pos = (sf::Vector2f)sf::Mouse::getPosition(win);
+    int hovered = nav_mesh != nullptr ? nav_mesh->FindNearest(mouse_pos, renderer.GetNodeRadius()) : -1;
 
-        // Additional logic bloc for modifying the nodes for the pathfinder 
-        if (node.Contains(sf::Mouse::getPosition(win)) && sf::Mouse::isButtonPressed(sf::Mouse::Left)
-            && index != nav_mesh->GetDestinationID() && stage == 2 && !dragging) {
-            nav_mesh->SetEntryPoint(index);
-        }
-        else if (node.Contains(sf::Mouse::getPosition(win)) && sf::Mouse::isButtonPressed(sf::Mouse::Right)
-            && index != nav_mesh->GetEntryPointID() && stage == 2 && !dragging) {
-            nav_mesh->SetDestination(index);
-        }
-
-        // dragging a node 
-        if (((node.Contains(sf::Mouse::getPosition(win)) && drag_node_id == -1) || drag_node_id == index) && dragging) {
-            drag_node_id = index;
-            sf::Vector2f mouse_pos = (sf::Vector2f)sf::Mouse::getPosition(win);
-            node.shape.setPosition(mouse_pos);
-            nav_mesh->GetNodes()[index].SetPosition(mouse_pos);
-            nav_mesh->Remake(win.getSize().x, win.getSize().y, mesh_size, GetObstacleData());
-            GetEdgeDisplay(); // only edges need to be re-generated 
-        }
-
-        // colour entry point and destination 
-        if (index == nav_mesh->GetEntryPointID()) node.shape.setFillColor(sf::Color::Green);
-        else if (index == nav_mesh->GetDestinationID()) node.shape.setFillColor(sf::Color::Yellow);
-        else node.shape.setFillColor(sf::Color::Red);
+    // Additional logic bloc for modifying the nodes for the pathfinder 
+    if (hovered != -1 && stage == 2 && !dragging) {
+        if (sf::Mouse::isButtonPressed(sf::Mouse::Left) && hovered != nav_mesh->GetDestinationID()) nav_mesh->SetEntryPoint(hovered);
+        else if (sf::Mouse::isButtonPressed(sf::Mouse::Right) && hovered != nav_mesh->GetEntryPointID()) nav_mesh->SetDestination(hovered);
+    }
 
-        // if in the path, change colour to green 
-        if (path.count(index) > 0 && index != nav_mesh->GetDestinationID()) node.shape.setFillColor(sf::Color::Green);
+    // dragging a node 
+    if (dragging && drag_node_id == -1) drag_node_id = hovered;
+    if (dragging && drag_node_id != -1) {
 
-        win.draw(node.shape);
-        ++index;
+        // only the edges around the node's old and new positions change 
+        if (nav_mesh->MoveNode(drag_node_id, mouse_pos)) renderer.MoveNode(*nav_mesh, drag_node_id);
+        else renderer.Build(*nav_mesh);
     }
+
+    if (nav_mesh != nullptr) renderer.SetMarkers(*nav_mesh, nav_mesh->GetEntryPointID(), nav_mesh->GetDestinationID());
+    renderer.Draw(win);
 }
 
 
@@ -128,10 +112,8 @@ void Interface::SetMeshSize() {
 
 
 void Interface::Reset() {
-    nodes.clear();
+    renderer.Clear();
     obstacles.clear();
-    edges.clear();
-    path.clear();
     dragging = false; 
     drag_node_id = -1; 
     if (nav_mesh != nullptr) delete nav_mesh;
@@ -139,28 +121,6 @@ void Interface::Reset() {
 }
 
 
-void Interface::GetNodesInterface() {
-    nodes.clear();
-    for (int i = 0; i < nav_mesh->GetNodes().size(); ++i) nodes.push_back(Node(nav_mesh->GetNodes()[i].GetPosition()));
-}
-
-
-void Interface::GetEdgeDisplay() {
-    edges.clear(); 
-    for (const auto& [edge_id, pair] : nav_mesh->GetEdges()) {
-
-        sf::Vector2f pos_s = nav_mesh->GetNodeData(pair.first).position;
-        sf::Vector2f pos_e = nav_mesh->GetNodeData(pair.second).position;
-
-        sf::Color col = sf::Color::Red;
-        if (path.count(pair.first) > 0 && path.count(pair.second) > 0) col = sf::Color::Green;
-
-        edges.push_back(sf::Vertex(pos_s, col));
-        edges.push_back(sf::Vertex(pos_e, col));
-    }
-}
-
-
 void Interface::GetObstacleDisplay(int sc_w, int sc_h) {
 
     std::random_device rd;
@@ -185,4 +145,4 @@ std::vector<std::pair<sf::Vector2f, sf::Vector2f>> Interface::GetObstacleData()
 }
 
 
-void Interface::GetPath(std::vector<int> p) { for (int n : p) path[n] = 0; }
+void Interface::GetPath(const std::vector<int>& p) { renderer.SetPath(*nav_mesh, p); }
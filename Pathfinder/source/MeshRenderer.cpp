@@ -0,0 +1,261 @@
+#include "MeshRenderer.h"
+
+namespace {
+
+	// side of the node texture in pixels; the quads scale it down, so it stays round at any node radius 
+	const unsigned int TEXTURE_SIZE = 32;
+}
+
+MeshRenderer::MeshRenderer(float node_radius) : node_radius(node_radius), node_buffer(sf::Triangles, sf::VertexBuffer::Dynamic), edge_buffer(sf::Lines, sf::VertexBuffer::Dynamic) {
+
+	// a white disc on transparent, with a one pixel soft edge 
+	sf::Image disc;
+	disc.create(TEXTURE_SIZE, TEXTURE_SIZE, sf::Color::Transparent);
+	float centre = TEXTURE_SIZE / 2.0f;
+	for (unsigned int y = 0; y < TEXTURE_SIZE; ++y) {
+		for (unsigned int x = 0; x < TEXTURE_SIZE; ++x) {
+			float dx = x + 0.5f - centre;
+			float dy = y + 0.5f - centre;
+			float coverage = std::min(1.0f, std::max(0.0f, centre - std::sqrt(dx * dx + dy * dy) + 0.5f));
+			disc.setPixel(x, y, sf::Color(255, 255, 255, (sf::Uint8)(coverage * 255.0f)));
+		}
+	}
+	node_texture.loadFromImage(disc);
+	node_texture.setSmooth(true);
+
+	use_buffers = sf::VertexBuffer::isAvailable();
+}
+
+
+sf::Color MeshRenderer::NodeColour(int id) const {
+	if (id == destination_id) return sf::Color::Yellow;
+	if (id == entry_point_id || on_path[id]) return sf::Color::Green;
+	return sf::Color::Red;
+}
+
+void MeshRenderer::WriteNode(int id, sf::Vector2f pos) {
+
+	sf::Color col = NodeColour(id);
+	float t = (float)TEXTURE_SIZE;
+	const sf::Vector2f corners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+	const int order[NODE_VERTICES] = { 0, 1, 2, 0, 2, 3 };
+
+	sf::Vertex* quad = &node_vertices[(size_t)id * NODE_VERTICES];
+	for (int i = 0; i < NODE_VERTICES; ++i) {
+		sf::Vector2f corner = corners[order[i]];
+		quad[i].position = sf::Vector2f(pos.x + corner.x * node_radius, pos.y + corner.y * node_radius);
+		quad[i].color = col;
+		quad[i].texCoords = sf::Vector2f((corner.x + 1.0f) * 0.5f * t, (corner.y + 1.0f) * 0.5f * t);
+	}
+
+	if (!full_upload && !node_dirty[id]) {
+		node_dirty[id] = true;
+		dirty_nodes.push_back(id);
+	}
+}
+
+void MeshRenderer::WriteEdge(int slot, sf::Vector2f s_pos, sf::Vector2f e_pos, sf::Color col) {
+
+	edge_vertices[2 * (size_t)slot] = sf::Vertex(s_pos, col);
+	edge_vertices[2 * (size_t)slot + 1] = sf::Vertex(e_pos, col);
+
+	if ((int)edge_dirty.size() <= slot) edge_dirty.resize(slot + 1, false);
+	if (!full_upload && !edge_dirty[slot]) {
+		edge_dirty[slot] = true;
+		dirty_edges.push_back(slot);
+	}
+}
+
+void MeshRenderer::RecolourNode(const NavMesh& mesh, int id, bool edges) {
+
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	WriteNode(id, graph.Position(id));
+	if (!edges) return;
+
+	for (int k = graph.Begin(id); k < graph.End(id); ++k) {
+		int s = std::min(id, graph.neighbours[k]);
+		int e = std::max(id, graph.neighbours[k]);
+		auto slot = edge_slots.find(EdgeKey(s, e));
+		if (slot != edge_slots.end()) WriteEdge(slot->second, graph.Position(s), graph.Position(e), EdgeColour(s, e));
+	}
+}
+
+
+void MeshRenderer::Build(const NavMesh& mesh) {
+
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	int node_count = graph.NodeCount();
+
+	// the node ids stay valid across a rebuild of the same nodes 
+	if ((int)on_path.size() != node_count) {
+		on_path.assign(node_count, false);
+		path_nodes.clear();
+	}
+	if (entry_point_id >= node_count) entry_point_id = -1;
+	if (destination_id >= node_count) destination_id = -1;
+
+	full_upload = true;
+	dirty_nodes.clear();
+	dirty_edges.clear();
+	node_dirty.assign(node_count, false);
+
+	node_vertices.resize((size_t)node_count * NODE_VERTICES);
+	for (int i = 0; i < node_count; ++i) WriteNode(i, graph.Position(i));
+
+	edge_ids.clear();
+	edge_slots.clear();
+	edge_vertices.resize((size_t)graph.EdgeCount() * 2);
+	for (int s = 0; s < node_count; ++s) {
+		for (int k = graph.Begin(s); k < graph.End(s); ++k) {
+
+			// every edge is stored in both of its rows; draw it from the lower id only 
+			int e = graph.neighbours[k];
+			if (e < s) continue;
+
+			edge_slots[EdgeKey(s, e)] = (int)edge_ids.size();
+			edge_ids.push_back(std::make_pair(s, e));
+			WriteEdge((int)edge_ids.size() - 1, graph.Position(s), graph.Position(e), EdgeColour(s, e));
+		}
+	}
+	edge_dirty.assign(edge_ids.size(), false);
+}
+
+void MeshRenderer::MoveNode(const NavMesh& mesh, int id) {
+
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	const NavMesh::EdgeChanges& changes = mesh.GetEdgeChanges();
+
+	WriteNode(id, graph.Position(id));
+
+	// a removed edge's slot is refilled with the last edge, so the vertices stay packed 
+	for (const std::pair<int, int>& edge : changes.removed) {
+
+		auto slot = edge_slots.find(EdgeKey(edge.first, edge.second));
+		if (slot == edge_slots.end()) continue;
+
+		int i = slot->second;
+		int last = (int)edge_ids.size() - 1;
+		edge_slots.erase(slot);
+		if (i != last) {
+			edge_ids[i] = edge_ids[last];
+			edge_slots[EdgeKey(edge_ids[i].first, edge_ids[i].second)] = i;
+			WriteEdge(i, edge_vertices[2 * (size_t)last].position, edge_vertices[2 * (size_t)last + 1].position, edge_vertices[2 * (size_t)last].color);
+		}
+		edge_ids.pop_back();
+		edge_vertices.resize(edge_vertices.size() - 2);
+	}
+
+	for (const std::pair<int, int>& edge : changes.added) {
+
+		int s = edge.first;
+		int e = edge.second;
+
+		edge_slots[EdgeKey(s, e)] = (int)edge_ids.size();
+		edge_ids.push_back(edge);
+		edge_vertices.resize(edge_vertices.size() + 2);
+		WriteEdge((int)edge_ids.size() - 1, graph.Position(s), graph.Position(e), EdgeColour(s, e));
+	}
+}
+
+void MeshRenderer::SetPath(const NavMesh& mesh, const std::vector<int>& path) {
+
+	std::vector<int> previous;
+	previous.swap(path_nodes);
+	for (int id : previous) on_path[id] = false;
+	for (int id : path) on_path[id] = true;
+	path_nodes = path;
+
+	// both paths' nodes and the edges around them change colour 
+	for (int id : previous) RecolourNode(mesh, id, true);
+	for (int id : path) RecolourNode(mesh, id, true);
+}
+
+void MeshRenderer::SetMarkers(const NavMesh& mesh, int entry_point, int destination) {
+
+	if (entry_point == entry_point_id && destination == destination_id) return;
+
+	int previous[2] = { entry_point_id, destination_id };
+	entry_point_id = entry_point;
+	destination_id = destination;
+	for (int id : { previous[0], previous[1], entry_point, destination }) if (id != -1) RecolourNode(mesh, id, false);
+}
+
+void MeshRenderer::Clear() {
+	node_vertices.clear();
+	edge_vertices.clear();
+	edge_ids.clear();
+	edge_slots.clear();
+	on_path.clear();
+	path_nodes.clear();
+	entry_point_id = destination_id = -1;
+	dirty_nodes.clear();
+	dirty_edges.clear();
+	node_dirty.clear();
+	edge_dirty.clear();
+	full_upload = true;
+}
+
+
+void MeshRenderer::Upload(sf::VertexBuffer& buffer, size_t& capacity, const std::vector<sf::Vertex>& vertices, std::vector<int>& dirty, std::vector<bool>& flags, int vertices_per_slot) {
+
+	size_t count = vertices.size();
+	if (full_upload || count > capacity) {
+		if (count > capacity) {
+			capacity = std::max(count, capacity + capacity / 2);
+			buffer.create(capacity);
+		}
+		if (count > 0) {
+			buffer.update(vertices.data(), count, 0);
+			++stats.uploads;
+			stats.uploaded_vertices += (int)count;
+		}
+	}
+	else {
+		// adjacent slots go up together 
+		std::sort(dirty.begin(), dirty.end());
+		int slot_count = (int)(count / vertices_per_slot);
+		for (size_t i = 0; i < dirty.size() && dirty[i] < slot_count;) {
+			size_t j = i + 1;
+			while (j < dirty.size() && dirty[j] == dirty[j - 1] + 1 && dirty[j] < slot_count) ++j;
+
+			size_t first = (size_t)dirty[i] * vertices_per_slot;
+			size_t length = (size_t)(dirty[j - 1] - dirty[i] + 1) * vertices_per_slot;
+			buffer.update(vertices.data() + first, length, (unsigned int)first);
+			++stats.uploads;
+			stats.uploaded_vertices += (int)length;
+			i = j;
+		}
+	}
+
+	for (int slot : dirty) if (slot < (int)flags.size()) flags[slot] = false;
+	dirty.clear();
+}
+
+void MeshRenderer::Draw(sf::RenderTarget& target) {
+
+	stats = Stats();
+
+	if (use_buffers) {
+		Upload(node_buffer, node_capacity, node_vertices, dirty_nodes, node_dirty, NODE_VERTICES);
+		Upload(edge_buffer, edge_capacity, edge_vertices, dirty_edges, edge_dirty, 2);
+	}
+	else {
+		for (int id : dirty_nodes) node_dirty[id] = false;
+		for (int slot : dirty_edges) if (slot < (int)edge_dirty.size()) edge_dirty[slot] = false;
+		dirty_nodes.clear();
+		dirty_edges.clear();
+	}
+	full_upload = false;
+
+	sf::RenderStates nodes_states(&node_texture);
+	if (!edge_vertices.empty()) {
+		if (use_buffers) target.draw(edge_buffer, 0, edge_vertices.size());
+		else target.draw(edge_vertices.data(), edge_vertices.size(), sf::Lines);
+		++stats.draw_calls;
+	}
+	if (!node_vertices.empty()) {
+		if (use_buffers) target.draw(node_buffer, 0, node_vertices.size(), nodes_states);
+		else target.draw(node_vertices.data(), node_vertices.size(), sf::Triangles, nodes_states);
+		++stats.draw_calls;
+	}
+}
@@ -0,0 +1,233 @@
+#include "MeshSnapshot.h"
+#include "Metrics.h"
+
+#include <cstddef> // offsetof, to leave the checksum field out of the checksum 
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	constexpr std::uint64_t ALIGNMENT = 64;
+
+	constexpr std::uint64_t Align(std::uint64_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+	// the header's share of the file; the first section starts right after it 
+	constexpr std::uint64_t HEADER_SPACE = Align(sizeof(MeshSnapshot::Header));
+
+	// the byte size every section must have 
+	void SectionSizes(std::uint64_t node_count, std::uint64_t edge_count, std::uint64_t obstacle_count, std::uint64_t* sizes) {
+		sizes[MeshSnapshot::XS] = sizeof(float) * node_count;
+		sizes[MeshSnapshot::YS] = sizeof(float) * node_count;
+		sizes[MeshSnapshot::OFFSETS] = sizeof(std::int32_t) * (node_count + 1);
+		sizes[MeshSnapshot::NEIGHBOURS] = sizeof(std::int32_t) * 2 * edge_count;
+		sizes[MeshSnapshot::WEIGHTS] = sizeof(float) * 2 * edge_count;
+		sizes[MeshSnapshot::EDGES] = sizeof(MeshSnapshot::Edge) * edge_count;
+		sizes[MeshSnapshot::OBSTACLES] = sizeof(MeshSnapshot::Obstacle) * obstacle_count;
+	}
+
+	// the checksum of a whole file: the header space with the checksum field taken as zero, then the sections 
+	std::uint64_t FileChecksum(const unsigned char* file, size_t size) {
+		unsigned char head[HEADER_SPACE];
+		std::memcpy(head, file, sizeof(head));
+		std::memset(head + offsetof(MeshSnapshot::Header, checksum), 0, sizeof(std::uint64_t));
+		return MeshSnapshot::Checksum(file + HEADER_SPACE, size - (size_t)HEADER_SPACE, MeshSnapshot::Checksum(head, sizeof(head)));
+	}
+}
+
+static_assert(sizeof(MeshSnapshot::Edge) == 12 && sizeof(MeshSnapshot::Obstacle) == 16, "snapshot records must not be padded");
+static_assert(sizeof(float) == 4, "snapshot floats are 32-bit");
+
+
+std::uint64_t MeshSnapshot::Checksum(const unsigned char* bytes, size_t size, std::uint64_t previous) {
+
+	// FNV-1a over 64-bit words, with a fold after every word so that the high bits also reach the low ones 
+	std::uint64_t h = previous;
+	for (size_t i = 0; i + 8 <= size; i += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+		h = (h ^ word) * 0x100000001b3ull;
+		h ^= h >> 32;
+	}
+	return h;
+}
+
+bool MeshSnapshot::Write(const NavMesh& mesh, const std::string& path) {
+
+	const NavMesh::Graph& graph = mesh.GetGraph();
+	const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles = mesh.GetObstacles();
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "NAVMESH", 8);
+	header.format_version = FORMAT_VERSION;
+	header.byte_order = BYTE_ORDER_MARK;
+	header.node_count = (std::uint32_t)graph.NodeCount();
+	header.edge_count = (std::uint32_t)graph.EdgeCount();
+	header.obstacle_count = (std::uint32_t)obstacles.size();
+	header.width = mesh.GetWidth();
+	header.height = mesh.GetHeight();
+	header.entry_point_id = mesh.GetEntryPointID();
+	header.destination_id = mesh.GetDestinationID();
+
+	std::uint64_t sizes[SECTION_COUNT];
+	SectionSizes(header.node_count, header.edge_count, header.obstacle_count, sizes);
+	std::uint64_t offset = HEADER_SPACE;
+	for (int i = 0; i < SECTION_COUNT; ++i) {
+		header.sections[i] = { offset, sizes[i] };
+		offset = Align(offset + sizes[i]);
+	}
+	header.file_size = offset;
+
+	// the file is assembled in 8-byte words, zero between the sections, so that the checksum can read it as such 
+	std::vector<std::uint64_t> words((size_t)(header.file_size / 8), 0);
+	unsigned char* bytes = reinterpret_cast<unsigned char*>(words.data());
+	auto put = [&](SectionID id, const void* source) {
+		if (header.sections[id].size > 0) std::memcpy(bytes + header.sections[id].offset, source, (size_t)header.sections[id].size);
+	};
+
+	put(XS, graph.xs.data());
+	put(YS, graph.ys.data());
+	if (graph.offsets.size() == (size_t)header.node_count + 1) put(OFFSETS, graph.offsets.data());
+	put(NEIGHBOURS, graph.neighbours.data());
+	put(WEIGHTS, graph.weights.data());
+
+	Edge* edges = reinterpret_cast<Edge*>(bytes + header.sections[EDGES].offset);
+	for (int s = 0, e = 0; s < graph.NodeCount(); ++s) {
+		for (int k = graph.Begin(s); k < graph.End(s); ++k) {
+			if (graph.neighbours[k] < s) continue;
+			edges[e++] = { s, graph.neighbours[k], graph.weights[k] };
+		}
+	}
+
+	Obstacle* rects = reinterpret_cast<Obstacle*>(bytes + header.sections[OBSTACLES].offset);
+	for (size_t i = 0; i < obstacles.size(); ++i) rects[i] = { obstacles[i].first.x, obstacles[i].first.y, obstacles[i].second.x, obstacles[i].second.y };
+
+	std::memcpy(bytes, &header, sizeof(header));
+	header.checksum = FileChecksum(bytes, (size_t)header.file_size);
+	std::memcpy(bytes + offsetof(Header, checksum), &header.checksum, sizeof(header.checksum));
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out || !out.write(reinterpret_cast<const char*>(bytes), (std::streamsize)header.file_size)) {
+		METRICS_EVENT("Could not write the snapshot " + path);
+		return false;
+	}
+	return true;
+}
+
+
+bool MeshSnapshot::Fail(const std::string& message) {
+	Close();
+	error = message;
+	return false;
+}
+
+bool MeshSnapshot::Open(const std::string& path) {
+
+	Close();
+	error.clear();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return Fail("Could not open " + path);
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(file, &file_size)) size = (size_t)file_size.QuadPart;
+	HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	if (mapping != nullptr) {
+		data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) return Fail("Could not open " + path);
+	struct stat status;
+	if (fstat(file, &status) == 0) size = (size_t)status.st_size;
+	if (size > 0) {
+		void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view != MAP_FAILED) data = static_cast<const unsigned char*>(view);
+	}
+	close(file);
+#endif
+	mapped = data != nullptr;
+
+	// where the file cannot be mapped, it is read into memory instead 
+	if (data == nullptr) {
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		if (!in) return Fail("Could not open " + path);
+		size = (size_t)in.tellg();
+		buffer.assign((size + 7) / 8, 0);
+		in.seekg(0);
+		if (!in.read(reinterpret_cast<char*>(buffer.data()), (std::streamsize)size)) return Fail("Could not read " + path);
+		data = reinterpret_cast<const unsigned char*>(buffer.data());
+	}
+
+	if (size < HEADER_SPACE) return Fail(path + " is too short to be a snapshot");
+	const Header& header = GetHeader();
+	if (std::memcmp(header.magic, "NAVMESH", 8) != 0) return Fail(path + " is not a NavMesh snapshot");
+	if (header.byte_order != BYTE_ORDER_MARK) return Fail(path + " was written on a machine of the other byte order");
+	if (header.format_version != FORMAT_VERSION) {
+		return Fail(path + " has format version " + std::to_string(header.format_version) + ", expected " + std::to_string(FORMAT_VERSION));
+	}
+	if (header.file_size != size || size % 8 != 0) return Fail(path + " is truncated");
+
+	std::uint64_t sizes[SECTION_COUNT];
+	SectionSizes(header.node_count, header.edge_count, header.obstacle_count, sizes);
+	for (int i = 0; i < SECTION_COUNT; ++i) {
+		const Section& section = header.sections[i];
+		bool inside = section.offset >= HEADER_SPACE && section.offset <= size && section.size <= size - section.offset;
+		if (!inside || section.size != sizes[i] || section.offset % 8 != 0) return Fail(path + " has a corrupt section table");
+	}
+	return true;
+}
+
+void MeshSnapshot::Close() {
+	if (mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<unsigned char*>(data), size);
+#endif
+	}
+	data = nullptr;
+	size = 0;
+	mapped = false;
+	buffer.clear();
+}
+
+bool MeshSnapshot::Verify() {
+
+	if (!IsOpen()) {
+		error = "No snapshot is open";
+		return false;
+	}
+
+	const Header& header = GetHeader();
+	if (FileChecksum(data, size) != header.checksum) {
+		error = "Snapshot checksum mismatch";
+		return false;
+	}
+
+	int node_count = NodeCount();
+	const std::int32_t* offsets = Offsets();
+	const std::int32_t* neighbours = Neighbours();
+	bool valid = offsets[0] == 0 && offsets[node_count] == 2 * EdgeCount();
+	for (int i = 0; valid && i < node_count; ++i) valid = offsets[i] <= offsets[i + 1];
+	for (int k = 0; valid && k < 2 * EdgeCount(); ++k) valid = neighbours[k] >= 0 && neighbours[k] < node_count;
+
+	const Edge* edges = Edges();
+	for (int e = 0; valid && e < EdgeCount(); ++e) valid = edges[e].lo >= 0 && edges[e].lo < edges[e].hi && edges[e].hi < node_count;
+
+	if (!valid) error = "Snapshot adjacency names nodes that do not exist";
+	return valid;
+}
@@ -0,0 +1,111 @@
+#include "Metrics.h"
+
+std::atomic<Metrics::Sink*> Metrics::sinks[Metrics::MAX_SINKS] = {};
+
+
+bool Metrics::AddSink(Sink* sink) {
+	for (std::atomic<Sink*>& slot : sinks) {
+		Sink* empty = nullptr;
+		if (slot.compare_exchange_strong(empty, sink)) return true;
+	}
+	return false;
+}
+
+void Metrics::RemoveSink(Sink* sink) {
+	for (std::atomic<Sink*>& slot : sinks) {
+		Sink* installed = sink;
+		slot.compare_exchange_strong(installed, nullptr);
+	}
+}
+
+void Metrics::Count(Counter counter, long long amount) {
+	if (amount == 0) return;
+	for (std::atomic<Sink*>& slot : sinks) {
+		Sink* sink = slot.load(std::memory_order_acquire);
+		if (sink != nullptr) sink->Count(counter, amount);
+	}
+}
+
+void Metrics::Observe(Histogram histogram, long long value, long long times) {
+	if (times <= 0) return;
+	for (std::atomic<Sink*>& slot : sinks) {
+		Sink* sink = slot.load(std::memory_order_acquire);
+		if (sink != nullptr) sink->Observe(histogram, value, times);
+	}
+}
+
+void Metrics::Event(const std::string& text) {
+	for (std::atomic<Sink*>& slot : sinks) {
+		Sink* sink = slot.load(std::memory_order_acquire);
+		if (sink != nullptr) sink->Event(text);
+	}
+}
+
+
+int Metrics::Bucket(long long value) {
+	int bucket = 0;
+	while (value > 0 && bucket < BUCKETS - 1) {
+		value >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+const char* Metrics::Name(Counter counter) {
+	static const char* names[COUNTER_COUNT] = { "paths_found", "paths_not_found", "nodes_expanded", "heap_pushes", "heap_decreases", "point_insertions",
+		"circle_tests", "walk_steps", "edges_tested", "edges_rejected", "arena_allocations" };
+	return counter >= 0 && counter < COUNTER_COUNT ? names[counter] : "";
+}
+
+const char* Metrics::Name(Histogram histogram) {
+	static const char* names[HISTOGRAM_COUNT] = { "search_us", "sampling_us", "triangulation_us", "filtering_us", "update_us", "landmarks_us", "load_us", "cavity_size" };
+	return histogram >= 0 && histogram < HISTOGRAM_COUNT ? names[histogram] : "";
+}
+
+
+void Metrics::Totals::Count(Counter counter, long long amount) {
+	counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::Totals::Observe(Histogram histogram, long long value, long long times) {
+
+	counts[histogram].fetch_add(times, std::memory_order_relaxed);
+	sums[histogram].fetch_add(value * times, std::memory_order_relaxed);
+	buckets[histogram][Bucket(value)].fetch_add(times, std::memory_order_relaxed);
+
+	long long max = maxima[histogram].load(std::memory_order_relaxed);
+	while (value > max && !maxima[histogram].compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+void Metrics::Totals::Reset() {
+	for (std::atomic<long long>& counter : counters) counter.store(0, std::memory_order_relaxed);
+	for (int h = 0; h < HISTOGRAM_COUNT; ++h) {
+		counts[h].store(0, std::memory_order_relaxed);
+		sums[h].store(0, std::memory_order_relaxed);
+		maxima[h].store(0, std::memory_order_relaxed);
+		for (std::atomic<long long>& bucket : buckets[h]) bucket.store(0, std::memory_order_relaxed);
+	}
+	events.store(0, std::memory_order_relaxed);
+}
+
+Metrics::Totals::HistogramData Metrics::Totals::GetHistogram(Histogram histogram) const {
+	HistogramData data;
+	data.count = counts[histogram].load(std::memory_order_relaxed);
+	data.sum = sums[histogram].load(std::memory_order_relaxed);
+	data.max = maxima[histogram].load(std::memory_order_relaxed);
+	for (int b = 0; b < BUCKETS; ++b) data.buckets[b] = buckets[histogram][b].load(std::memory_order_relaxed);
+	return data;
+}
+
+
+void Metrics::Console::Observe(Histogram histogram, long long value, long long /*times*/) {
+
+	// the durations, in the milliseconds the console used to show 
+	static const char* phases[HISTOGRAM_COUNT] = { "Path search", "Sampling", "Triangulation", "Edge filtering", "Node move", "Landmarks", "Snapshot load", nullptr };
+	if (phases[histogram] == nullptr) return;
+	std::cout << phases[histogram] << " took " << value / 1000.0 << " milliseconds\n";
+}
+
+void Metrics::Console::Event(const std::string& text) {
+	std::cout << text << "\n";
+}
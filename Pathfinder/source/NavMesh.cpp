@@ -1,56 +1,147 @@
 #include "NavMesh.h"
+#include "AStar.h" // Dijkstra, for the landmark searches 
+#include "FreeSpaceSampler.h"
+#include "MeshSnapshot.h"
+#include "Metrics.h"
 #include "Bowyer-Watson.c"
 
-bool NavMesh::InsideObstacles(sf::Vector2f pt, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles) {
-	for (const auto& obs : obstacles) if (RectContains(pt, obs, 5.0f)) return true;
-	return false; 
+constexpr float NavMesh::LandmarkTable::UNREACHABLE;
+constexpr float NavMesh::OBSTACLE_CLEARANCE;
+
+// fewest points per strip of a parallel triangulation; below that, the seam left to triangulate serially outweighs the strips 
+static const int MIN_STRIP_POINTS = 4096;
+
+// graph versions are drawn from one counter for all meshes, so that a version never names two different graphs 
+static unsigned int NextVersion() {
+	static std::atomic<unsigned int> counter(0);
+	return ++counter;
 }
 
-bool NavMesh::RectContains(sf::Vector2f pt, const std::pair<sf::Vector2f, sf::Vector2f>& rect_data, float off) {
-	return pt.x >= rect_data.first.x - off && pt.x <= rect_data.first.x + rect_data.second.x + off 
-		&& pt.y >= rect_data.first.y - off && pt.y <= rect_data.first.y + rect_data.second.y + off;
+NavMesh::NavMesh(int sc_w, int sc_h, int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles) 
+	: NavMesh(sc_w, sc_h, pt_count, obstacles, std::random_device()()) {}
+
+NavMesh::NavMesh(int sc_w, int sc_h, int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles, unsigned int seed, unsigned int threads, float min_spacing) 
+	: entry_point_id(-1), destination_id(-1), build_threads(threads) {
+
+	SetObstacles(sc_w, sc_h, obstacles);
+
+	std::mt19937 gen(seed);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// about a sampler cell per node keeps the partly covered cells, where points may have to be drawn again, to a thin band around the 
+	// obstacles, for less time than the sampling itself takes 
+	FreeSpaceSampler sampler(sc_w, sc_h, obstacles, OBSTACLE_CLEARANCE, std::min(1 << 20, std::max(4096, pt_count)));
+	std::vector<sf::Vector2f> points = sampler.Sample(gen, pt_count, min_spacing);
+	if ((int)points.size() < pt_count) METRICS_EVENT("Only " + std::to_string(points.size()) + " of " + std::to_string(pt_count) + " nodes fit in the free space");
+
+	nodes.reserve(points.size());
+	for (const sf::Vector2f& pt : points) nodes.emplace_back(Node(pt));
+	timings.sampling_rejections = sampler.GetStats().rejected_obstacle + sampler.GetStats().rejected_spacing;
+
+	timings.sampling_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	METRICS_OBSERVE(SAMPLING_US, timings.sampling_us);
+
+	Rebuild();
 }
 
-NavMesh::NavMesh(int sc_w, int sc_h, int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles) : entry_point_id(-1), destination_id(-1) {
+NavMesh::NavMesh(const MeshSnapshot& snapshot, unsigned int threads) 
+	: entry_point_id(-1), destination_id(-1), build_threads(threads) {
 
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_real_distribution<float> width(0.0f, (float)sc_w);
-	std::uniform_real_distribution<float> height(0.0f, (float)sc_h);
+	auto start = std::chrono::high_resolution_clock::now();
 
-	for (int i = 0; i < pt_count; ++i) {
+	if (!snapshot.IsOpen()) {
+		METRICS_EVENT("Snapshot is not open");
+		SetObstacles(0, 0, {});
+		BuildGraph(nullptr);
+		rebuild_version = version = NextVersion();
+		return;
+	}
+
+	const MeshSnapshot::Header& header = snapshot.GetHeader();
+	std::vector<std::pair<sf::Vector2f, sf::Vector2f>> obstacles(snapshot.ObstacleCount());
+	for (int i = 0; i < snapshot.ObstacleCount(); ++i) {
+		const MeshSnapshot::Obstacle& rect = snapshot.Obstacles()[i];
+		obstacles[i] = std::make_pair(sf::Vector2f(rect.x, rect.y), sf::Vector2f(rect.w, rect.h));
+	}
+	SetObstacles(header.width, header.height, obstacles);
+
+	int node_count = snapshot.NodeCount();
+	int half_edges = 2 * snapshot.EdgeCount();
+	nodes.reserve(node_count);
+	for (int i = 0; i < node_count; ++i) nodes.emplace_back(Node(sf::Vector2f(snapshot.Xs()[i], snapshot.Ys()[i])));
+
+	graph.xs.assign(snapshot.Xs(), snapshot.Xs() + node_count);
+	graph.ys.assign(snapshot.Ys(), snapshot.Ys() + node_count);
+	graph.offsets.assign(snapshot.Offsets(), snapshot.Offsets() + node_count + 1);
+	graph.neighbours.assign(snapshot.Neighbours(), snapshot.Neighbours() + half_edges);
+	graph.weights.assign(snapshot.Weights(), snapshot.Weights() + half_edges);
+
+	// Open() only checks the section sizes; an adjacency that names missing nodes would send A* out of bounds 
+	bool valid = graph.offsets[0] == 0 && graph.offsets[node_count] == half_edges;
+	for (int i = 0; valid && i < node_count; ++i) valid = graph.offsets[i] <= graph.offsets[i + 1];
+	for (int k = 0; valid && k < half_edges; ++k) valid = graph.neighbours[k] >= 0 && graph.neighbours[k] < node_count;
 
-		sf::Vector2f pt = sf::Vector2f(width(gen), height(gen));
-		while (InsideObstacles(pt, obstacles)) pt = sf::Vector2f(width(gen), height(gen));
-		nodes.emplace_back(Node(pt));
+	if (valid) {
+		rebuild_version = version = NextVersion();
+		node_versions.assign(node_count, version);
+		node_grid.Build(graph);
+	}
+	else {
+		METRICS_EVENT("Snapshot adjacency is corrupt, re-triangulating its nodes");
+		Rebuild();
 	}
 
-	Remake(sc_w, sc_h, pt_count, obstacles);
+	if (header.entry_point_id >= 0 && header.entry_point_id < node_count) entry_point_id = header.entry_point_id;
+	if (header.destination_id >= 0 && header.destination_id < node_count) destination_id = header.destination_id;
+
+	timings.load_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	METRICS_OBSERVE(LOAD_US, timings.load_us);
+}
+
+NavMesh::~NavMesh() {
+	if (triangulation != nullptr) {
+		FreeTriangulation(triangulation);
+		delete triangulation;
+	}
+	if (scratch != nullptr) {
+		FreeArena(scratch);
+		delete scratch;
+	}
+	for (struct ScratchArena* arena : strip_scratch) {
+		FreeArena(arena);
+		delete arena;
+	}
+	if (obstacle_grid != nullptr) {
+		FreeObstacleGrid(obstacle_grid);
+		delete obstacle_grid;
+	}
 }
 
 void NavMesh::Remake(int sc_w, int sc_h, const int pt_count, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles) {
 
 	if (nodes.empty()) return;
 
-	Clear();
+	SetObstacles(sc_w, sc_h, obstacles);
 
-	// a circle that encompasses the area on which the mesh is to be defined - used by Bowyer-Watson to define the overarching triangle 
-	sf::Vector2f excircle_centre = sf::Vector2f(sc_w / 2.0f, sc_h / 2.0f);
-	float excircle_rad = std::sqrt(-excircle_centre.x * -excircle_centre.x + -excircle_centre.y * -excircle_centre.y);
+	if (pt_count != (int)nodes.size()) METRICS_EVENT("Remake() expects one point per node");
+	Rebuild();
+}
 
-	// convert the mesh data (points and obstacle vertices) into Bowyer-Watson's Point and Rect structs 
-	Point* cpoints = new Point[pt_count + 3]; // allocate 3 more points for Bowyer-Watson's super-triangle vertices 
-	for (int i = 0; i < pt_count; ++i) {
-		struct Point pt;
-		pt.x = nodes[i].GetPosition().x;
-		pt.y = nodes[i].GetPosition().y;
-		pt.id = i;
-		cpoints[i] = pt;
-	}
+void NavMesh::SetObstacles(int sc_w, int sc_h, const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& obstacles) {
+
+	width = sc_w;
+	height = sc_h;
+	obstacle_rects = obstacles;
+
+	// a circle that encompasses the area on which the mesh is to be defined - used by Bowyer-Watson to define the overarching triangle 
+	excircle_centre = sf::Vector2f(sc_w / 2.0f, sc_h / 2.0f);
+	excircle_rad = std::sqrt(-excircle_centre.x * -excircle_centre.x + -excircle_centre.y * -excircle_centre.y);
 
-	// assemble the obstacles array 
-	struct Rect* obs_arr = new Rect[(int)obstacles.size() + 1];
-	for (int i = 0; i < obstacles.size(); ++i) {
+	// assemble the obstacles array, in Bowyer-Watson's Rect struct 
+	int obs_count = (int)obstacles.size();
+	struct Rect* obs_arr = new Rect[obs_count + 1];
+	for (int i = 0; i < obs_count; ++i) {
 		Rect obs;
 		obs.edges[0] = { {obstacles[i].first.x, obstacles[i].first.y},
 			{obstacles[i].first.x, obstacles[i].first.y + obstacles[i].second.y} };
@@ -63,35 +154,642 @@ void NavMesh::Remake(int sc_w, int sc_h, const int pt_count, const std::vector<s
 		obs_arr[i] = obs; 
 	}
 
-	std::cout << "Triangulating the nodes...\n";
+	if (obstacle_grid == nullptr) {
+		obstacle_grid = new ObstacleGrid;
+		InitObstacleGrid(obstacle_grid);
+	}
+	if (!BuildObstacleGrid(obstacle_grid, obs_arr, obs_count)) METRICS_EVENT("Obstacle grid allocation failed");
+
+	delete[] obs_arr;
+}
+
+void NavMesh::Rebuild() {
+
+	Clear();
+
+	rebuild_version = version = NextVersion();
+	node_versions.assign(nodes.size(), version);
+
+	if (scratch == nullptr) {
+		scratch = new ScratchArena;
+		InitArena(scratch);
+	}
+	ResetArenaPeak(scratch);
+
+	// the triangulation's buffers are reused as long as the node count stays the same 
+	int pt_count = (int)nodes.size();
+	if (triangulation != nullptr && triangulation->pt_count != pt_count) {
+		FreeTriangulation(triangulation);
+		delete triangulation;
+		triangulation = nullptr;
+	}
+	if (triangulation == nullptr) {
+		triangulation = new Triangulation;
+		if (!InitTriangulation(triangulation, pt_count)) {
+			FreeTriangulation(triangulation);
+			delete triangulation;
+			triangulation = nullptr;
+			BuildGraph(nullptr);
+			METRICS_EVENT("Triangulation failed");
+			return;
+		}
+	}
+
+	triangulation->insertion_order = brio_order ? INSERT_BRIO : INSERT_INDEX;
+	reported_walk_steps = 0; // the build starts walk_steps over 
+
+	// convert the nodes into Bowyer-Watson's Point struct 
+	for (int i = 0; i < pt_count; ++i) {
+		struct Point pt;
+		pt.x = nodes[i].GetPosition().x;
+		pt.y = nodes[i].GetPosition().y;
+		pt.id = i;
+		triangulation->points[i] = pt;
+	}
+
 	auto start = std::chrono::high_resolution_clock::now();
 
-	// call Bowyer-Watson's triangulation algorithm 
-	struct Edge* triangulation = BowyerWatson(pt_count, cpoints, excircle_rad, excircle_centre.x, excircle_centre.y, obs_arr, (int)obstacles.size());
+	// call Bowyer-Watson's triangulation algorithm, one stage at a time so that both can be timed 
+	timings.merge_us = 0;
+	int strip_count = (int)(build_threads > 0 ? build_threads : std::max(1u, std::thread::hardware_concurrency()));
+	strip_count = std::min(strip_count, pt_count / MIN_STRIP_POINTS);
+	timings.triangulation_strips = strip_count >= 2 && BuildParallel(strip_count) ? strip_count : 1;
+
+	int tr_count = 0;
+	int* triangles = nullptr;
+	if (timings.triangulation_strips > 1 || BuildTriangulation(triangulation, excircle_rad, excircle_centre.x, excircle_centre.y, scratch)) triangles = CollectTriangles(triangulation, &tr_count);
+	timings.walk_steps = triangulation->walk_steps;
+	auto filtering_start = std::chrono::high_resolution_clock::now();
+	timings.triangulation_us = std::chrono::duration_cast<std::chrono::microseconds>(filtering_start - start).count();
+
+	int rejected = 0;
+	struct Edge* edges = FilterEdges(triangles, tr_count, triangulation->points, obstacle_grid, scratch, &rejected);
+	if (triangles != nullptr) free(triangles);
+	scratch_peak = scratch->peak;
+	timings.filtering_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - filtering_start).count();
+
+	BuildGraph(edges);
+
+	METRICS_OBSERVE(TRIANGULATION_US, timings.triangulation_us);
+	METRICS_OBSERVE(FILTERING_US, timings.filtering_us);
+	METRICS_COUNT(EDGES_TESTED, graph.EdgeCount() + rejected);
+	METRICS_COUNT(EDGES_REJECTED, rejected);
+	ReportTriangulation();
+
+	if (landmark_count > 0) BuildLandmarks(landmark_count);
 
-	if (triangulation == nullptr) std::cout << "Triangulation failed\n\n";
+	// a failed build leaves the store unusable, and MoveNode() will rebuild from scratch 
+	if (tr_count == 0) {
+		FreeTriangulation(triangulation);
+		delete triangulation;
+		triangulation = nullptr;
+	}
+
+	if (edges == nullptr) METRICS_EVENT("Triangulation failed");
 	else {
-		int index = 0; 
-		while (triangulation[index].last != 1) {
-			nodes[triangulation[index].start].AddNeighbour(triangulation[index].weight, triangulation[index].end);
-			nodes[triangulation[index].end].AddNeighbour(triangulation[index].weight, triangulation[index].start);
-			edges[CantorPair(triangulation[index].start, triangulation[index].end)] = std::make_pair(triangulation[index].start, triangulation[index].end);
-			++index;
+		if (graph.EdgeCount() == 0) METRICS_EVENT("No valid edges remaining");
+		free(edges);
+	}
+}
+
+void NavMesh::ReportTriangulation() {
+#ifndef PATHFINDER_NO_METRICS
+	if (triangulation != nullptr) {
+		const TriangulationCounters& counters = triangulation->counters;
+		METRICS_COUNT(POINT_INSERTIONS, counters.insertions);
+		METRICS_COUNT(CIRCLE_TESTS, counters.circle_tests);
+		METRICS_COUNT(WALK_STEPS, triangulation->walk_steps - reported_walk_steps);
+		for (int b = 0; b < CAVITY_BUCKETS; ++b) METRICS_OBSERVE_TIMES(CAVITY_SIZE, b == 0 ? 0 : 1LL << (b - 1), counters.cavity_sizes[b]);
+		ResetCounters(&triangulation->counters);
+		reported_walk_steps = triangulation->walk_steps;
+	}
+
+	long long arena_allocs = scratch != nullptr ? scratch->heap_allocs : 0;
+	for (const struct ScratchArena* arena : strip_scratch) arena_allocs += arena->heap_allocs;
+	METRICS_COUNT(ARENA_ALLOCATIONS, arena_allocs - reported_arena_allocs);
+	reported_arena_allocs = arena_allocs;
+#endif
+}
+
+
+bool NavMesh::BuildParallel(int strip_count) {
+
+	int pt_count = triangulation->pt_count;
+	const struct Point* points = triangulation->points;
+
+	// strips hold consecutive ranks in x, but list their points in node order, as the serial build does before ordering the insertion 
+	std::vector<int> order(pt_count);
+	for (int i = 0; i < pt_count; ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [points](int a, int b) {
+		return points[a].x < points[b].x || (points[a].x == points[b].x && (points[a].y < points[b].y || (points[a].y == points[b].y && a < b)));
+	});
+
+	std::vector<int> strip_of(pt_count);
+	std::vector<int> strip_size(strip_count, 0);
+	for (int r = 0; r < pt_count; ++r) {
+		int s = (int)((long long)r * strip_count / pt_count);
+		strip_of[order[r]] = s;
+		++strip_size[s];
+	}
+
+	while ((int)strip_scratch.size() < strip_count) {
+		strip_scratch.push_back(new ScratchArena);
+		InitArena(strip_scratch.back());
+	}
+
+	std::vector<StripResult> results(strip_count);
+	std::vector<char> built(strip_count, 0);
+
+	auto worker = [&](int s) {
+
+		// the x of the neighbouring strips' nearest points bound the circumcircles of the strip's final triangles 
+		int first = (int)(((long long)s * pt_count + strip_count - 1) / strip_count);
+		int last = first + strip_size[s];
+		double lo = s > 0 ? points[order[first - 1]].x : -HUGE_VAL;
+		double hi = s + 1 < strip_count ? points[order[last]].x : HUGE_VAL;
+
+		struct Triangulation strip;
+		if (InitTriangulation(&strip, strip_size[s])) {
+			strip.insertion_order = triangulation->insertion_order;
+			for (int i = 0, n = 0; i < pt_count; ++i) if (strip_of[i] == s) strip.points[n++] = points[i];
+			built[s] = (char)BuildStrip(&strip, lo, hi, excircle_rad, excircle_centre.x, excircle_centre.y, strip_scratch[s], &results[s]);
 		}
-		free(triangulation);
-		std::cout << "Triangulation finished in " << 
-			std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << " milliseconds\n\n";
+		FreeTriangulation(&strip);
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(strip_count - 1);
+	for (int s = 1; s < strip_count; ++s) workers.emplace_back(worker, s);
+	worker(0); // the calling thread works too 
+	for (std::thread& t : workers) t.join();
+
+	bool ok = std::find(built.begin(), built.end(), 0) == built.end();
+	auto merge_start = std::chrono::high_resolution_clock::now();
+	if (ok) ok = MergeStrips(triangulation, results.data(), strip_count, excircle_rad, excircle_centre.x, excircle_centre.y, scratch) == 1;
+	timings.merge_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - merge_start).count();
+
+	for (StripResult& res : results) FreeStripResult(&res);
+	return ok;
+}
+
+
+bool NavMesh::EdgeValid(int a, int b) const {
+	if (a > b) std::swap(a, b);
+	struct ObsEdge edge = { triangulation->points[a], triangulation->points[b] };
+	return GridObstacleCheck(obstacle_grid, edge) == 1;
+}
+
+
+int NavMesh::LoadLink(int id) {
+	int count = GetVertexLink(triangulation, id, link.data(), (int)link.size());
+	if (count > (int)link.size()) {
+		link.resize(count);
+		count = GetVertexLink(triangulation, id, link.data(), (int)link.size());
 	}
+	return count;
+}
+
+
+bool NavMesh::MoveNode(int id, sf::Vector2f pos) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	nodes[id].SetPosition(pos);
+	edge_changes.removed.clear();
+	edge_changes.added.clear();
 
-	if (cpoints != nullptr) delete[] cpoints;
-	if (obs_arr != nullptr) delete[] obs_arr;
+	// the moved edges may have shortened paths, and a stale table could overestimate 
+	landmarks = LandmarkTable();
+
+	if (triangulation == nullptr) {
+		Rebuild();
+		timings.update_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		METRICS_OBSERVE(UPDATE_US, timings.update_us);
+		return false;
+	}
+
+	int pt_count = triangulation->pt_count;
+	if ((int)touched_row.size() != pt_count) touched_row.assign(pt_count, -1);
+	touched.clear();
+
+	auto touch = [&](int v) {
+		if (v >= pt_count || touched_row[v] != -1) return; // super-triangle vertices are not nodes 
+		touched_row[v] = 0;
+		touched.push_back(v);
+	};
+
+	// every edge that the move creates or destroys joins two nodes of the moved node's star, before or after the move: 
+	// its old neighbours are re-triangulated among themselves, and the vertices of its insertion cavity all become its new neighbours 
+	touch(id);
+	for (int i = 0, count = LoadLink(id); i < count; ++i) touch(link[i]);
+	if (!MovePoint(triangulation, id, pos.x, pos.y, scratch)) {
+		for (int v : touched) touched_row[v] = -1;
+		Rebuild();
+		timings.update_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		METRICS_OBSERVE(UPDATE_US, timings.update_us);
+		return false;
+	}
+	for (int i = 0, count = LoadLink(id); i < count; ++i) touch(link[i]);
+
+	graph.xs[id] = pos.x;
+	graph.ys[id] = pos.y;
+	node_grid.Move(graph, id);
+
+	// the new rows of the touched nodes, in id order 
+	std::sort(touched.begin(), touched.end());
+	int edge_tests = 0;
+	int edge_rejections = 0;
+	rows.clear();
+	row_offsets.clear();
+	for (int r = 0; r < (int)touched.size(); ++r) {
+
+		int u = touched[r];
+		touched_row[u] = r;
+		row_offsets.push_back((int)rows.size());
+
+		for (int i = 0, count = LoadLink(u); i < count; ++i) {
+			int w = link[i];
+			if (w >= pt_count) continue;
+
+			// an edge to an untouched node did not change, so it is in the graph if it was before 
+			if (touched_row[w] == -1) {
+				for (int j = graph.Begin(u); j < graph.End(u); ++j) if (graph.neighbours[j] == w) rows.push_back({ w, graph.weights[j] });
+			}
+			else {
+				++edge_tests;
+				if (EdgeValid(u, w)) rows.push_back({ w, GetWeight(triangulation->points[u], triangulation->points[w]) });
+				else ++edge_rejections;
+			}
+		}
+	}
+	row_offsets.push_back((int)rows.size());
+
+	// compare the old and new rows; an edge between two touched nodes is reported from its lower end only 
+	auto in_new_row = [&](int r, int w) {
+		for (int k = row_offsets[r]; k < row_offsets[r + 1]; ++k) if (rows[k].first == w) return true;
+		return false;
+	};
+	auto in_old_row = [&](int u, int w) {
+		for (int j = graph.Begin(u); j < graph.End(u); ++j) if (graph.neighbours[j] == w) return true;
+		return false;
+	};
+	for (int r = 0; r < (int)touched.size(); ++r) {
+
+		int u = touched[r];
+		for (int j = graph.Begin(u); j < graph.End(u); ++j) {
+			int w = graph.neighbours[j];
+			if (w < u && touched_row[w] != -1) continue;
+			if (u == id || w == id || !in_new_row(r, w)) edge_changes.removed.push_back({ std::min(u, w), std::max(u, w) });
+		}
+		for (int k = row_offsets[r]; k < row_offsets[r + 1]; ++k) {
+			int w = rows[k].first;
+			if (w < u && touched_row[w] != -1) continue;
+			if (u == id || w == id || !in_old_row(u, w)) edge_changes.added.push_back({ std::min(u, w), std::max(u, w) });
+		}
+	}
+
+	// splice the new rows into the graph; the runs of untouched rows between them are copied over whole, with their offsets shifted 
+	int node_count = graph.NodeCount();
+	spare.offsets.resize(node_count + 1);
+	spare.neighbours.clear();
+	spare.weights.clear();
+	spare.offsets[0] = 0;
+
+	int next = 0; // the first row yet to be copied 
+	for (int r = 0; r <= (int)touched.size(); ++r) {
+
+		int u = r < (int)touched.size() ? touched[r] : node_count;
+		int shift = (int)spare.neighbours.size() - graph.offsets[next];
+		spare.neighbours.insert(spare.neighbours.end(), graph.neighbours.begin() + graph.offsets[next], graph.neighbours.begin() + graph.offsets[u]);
+		spare.weights.insert(spare.weights.end(), graph.weights.begin() + graph.offsets[next], graph.weights.begin() + graph.offsets[u]);
+		for (int i = next; i < u; ++i) spare.offsets[i + 1] = graph.offsets[i + 1] + shift;
+		if (u == node_count) break;
+
+		for (int k = row_offsets[r]; k < row_offsets[r + 1]; ++k) {
+			spare.neighbours.push_back(rows[k].first);
+			spare.weights.push_back(rows[k].second);
+		}
+		spare.offsets[u + 1] = (int)spare.neighbours.size();
+		next = u + 1;
+	}
+	std::swap(graph.offsets, spare.offsets);
+	std::swap(graph.neighbours, spare.neighbours);
+	std::swap(graph.weights, spare.weights);
+
+	version = NextVersion();
+	for (const std::pair<int, int>& edge : edge_changes.removed) node_versions[edge.first] = node_versions[edge.second] = version;
+	for (const std::pair<int, int>& edge : edge_changes.added) node_versions[edge.first] = node_versions[edge.second] = version;
+
+	for (int v : touched) touched_row[v] = -1;
+
+	timings.update_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	METRICS_OBSERVE(UPDATE_US, timings.update_us);
+	METRICS_COUNT(EDGES_TESTED, edge_tests);
+	METRICS_COUNT(EDGES_REJECTED, edge_rejections);
+	ReportTriangulation();
+	return true;
 }
 
 
+bool NavMesh::Save(const std::string& path) const {
+	return MeshSnapshot::Write(*this, path);
+}
+
 
 void NavMesh::Clear() {
-	edges.clear();
-	for (auto& node : nodes) node.ClearNeighbours();
+	// clear rather than reassign, so that repeated Remake() calls reuse the graph's capacity 
+	graph.offsets.clear();
+	graph.neighbours.clear();
+	graph.weights.clear();
+	graph.xs.clear();
+	graph.ys.clear();
+}
+
+
+void NavMesh::BuildGraph(const struct Edge* triangulation) {
+
+	int node_count = (int)nodes.size();
+
+	graph.xs.resize(node_count);
+	graph.ys.resize(node_count);
+	for (int i = 0; i < node_count; ++i) {
+		graph.xs[i] = nodes[i].GetPosition().x;
+		graph.ys[i] = nodes[i].GetPosition().y;
+	}
+
+	// count the degree of every node, then turn the counts into row offsets 
+	graph.offsets.assign(node_count + 1, 0);
+	int edge_count = 0;
+	if (triangulation != nullptr) {
+		for (; triangulation[edge_count].last != 1; ++edge_count) {
+			++graph.offsets[triangulation[edge_count].start + 1];
+			++graph.offsets[triangulation[edge_count].end + 1];
+		}
+	}
+	for (int i = 0; i < node_count; ++i) graph.offsets[i + 1] += graph.offsets[i];
+
+	// scatter both directions of every edge into its rows 
+	graph.neighbours.resize(edge_count * 2);
+	graph.weights.resize(edge_count * 2);
+	std::vector<int> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+	for (int i = 0; i < edge_count; ++i) {
+		const struct Edge& edge = triangulation[i];
+		graph.neighbours[fill[edge.start]] = edge.end;
+		graph.weights[fill[edge.start]++] = edge.weight;
+		graph.neighbours[fill[edge.end]] = edge.start;
+		graph.weights[fill[edge.end]++] = edge.weight;
+	}
+
+	node_grid.Build(graph);
+}
+
+
+void NavMesh::NodeGrid::Build(const Graph& graph) {
+
+	int node_count = graph.NodeCount();
+	next.assign(node_count, -1);
+	cell.assign(node_count, 0);
+	if (node_count == 0) {
+		cols = rows = 0;
+		head.clear();
+		return;
+	}
+
+	min_x = max_x = graph.xs[0];
+	min_y = max_y = graph.ys[0];
+	for (int i = 1; i < node_count; ++i) {
+		min_x = std::min(min_x, graph.xs[i]);
+		max_x = std::max(max_x, graph.xs[i]);
+		min_y = std::min(min_y, graph.ys[i]);
+		max_y = std::max(max_y, graph.ys[i]);
+	}
+
+	// square cells of about two nodes each, but never more cells along a side than nodes 
+	float w = std::max(max_x - min_x, 1.0f);
+	float h = std::max(max_y - min_y, 1.0f);
+	float side = std::sqrt(w * h * 2.0f / node_count);
+	cols = std::max(1, std::min(node_count, (int)std::ceil(w / side)));
+	rows = std::max(1, std::min(node_count, (int)std::ceil(h / side)));
+	cell_w = w / cols;
+	cell_h = h / rows;
+
+	// chained in reverse, so that every cell lists its nodes by id 
+	head.assign((size_t)cols * rows, -1);
+	for (int i = node_count - 1; i >= 0; --i) {
+		int c = Row(graph.ys[i]) * cols + Col(graph.xs[i]);
+		cell[i] = c;
+		next[i] = head[c];
+		head[c] = i;
+	}
+}
+
+void NavMesh::NodeGrid::Move(const Graph& graph, int id) {
+
+	float x = graph.xs[id];
+	float y = graph.ys[id];
+	if (x < min_x || x > max_x || y < min_y || y > max_y) {
+		Build(graph);
+		return;
+	}
+
+	int c = Row(y) * cols + Col(x);
+	if (c == cell[id]) return;
+
+	int* link = &head[cell[id]];
+	while (*link != id) link = &next[*link];
+	*link = next[id];
+
+	cell[id] = c;
+	next[id] = head[c];
+	head[c] = id;
+}
+
+float NavMesh::NodeGrid::RingBound(sf::Vector2f pt, int col, int row, int ring) const {
+
+	if (ring == 0) return 0.0f;
+
+	// the nodes outside the box of cells within ring - 1 lie beyond one of its sides, unless that side is the grid's own 
+	float bound = std::numeric_limits<float>::infinity();
+	if (col - ring + 1 > 0) bound = std::min(bound, pt.x - (min_x + (col - ring + 1) * cell_w));
+	if (col + ring - 1 < cols - 1) bound = std::min(bound, min_x + (col + ring) * cell_w - pt.x);
+	if (row - ring + 1 > 0) bound = std::min(bound, pt.y - (min_y + (row - ring + 1) * cell_h));
+	if (row + ring - 1 < rows - 1) bound = std::min(bound, min_y + (row + ring) * cell_h - pt.y);
+	return bound;
+}
+
+template <typename Visit>
+void NavMesh::NodeGrid::VisitRing(int col, int row, int ring, Visit visit) const {
+
+	int c0 = std::max(0, col - ring);
+	int c1 = std::min(cols - 1, col + ring);
+	for (int r = std::max(0, row - ring); r <= std::min(rows - 1, row + ring); ++r) {
+
+		// the first and last row of the ring are whole, the rows between only have its two end cells 
+		if (r == row - ring || r == row + ring) {
+			for (int c = c0; c <= c1; ++c) for (int id = head[r * cols + c]; id != -1; id = next[id]) visit(id);
+			continue;
+		}
+		if (col - ring >= 0) for (int id = head[r * cols + col - ring]; id != -1; id = next[id]) visit(id);
+		if (col + ring < cols) for (int id = head[r * cols + col + ring]; id != -1; id = next[id]) visit(id);
+	}
+}
+
+int NavMesh::NodeGrid::Nearest(const Graph& graph, sf::Vector2f pt, float max_dist) const {
+
+	if (cols == 0) return -1;
+
+	// every node lies in the bounding box, and pt clamped into it is no farther from any of them, so its bounds hold for pt 
+	sf::Vector2f clamped(std::min(max_x, std::max(min_x, pt.x)), std::min(max_y, std::max(min_y, pt.y)));
+	int col = Col(clamped.x);
+	int row = Row(clamped.y);
+
+	int best = -1;
+	float best_d2 = max_dist * max_dist;
+	for (int ring = 0; ring < std::max(cols, rows); ++ring) {
+
+		float bound = RingBound(clamped, col, row, ring);
+		if (bound * bound > best_d2) break;
+
+		VisitRing(col, row, ring, [&](int id) {
+			float dx = graph.xs[id] - pt.x;
+			float dy = graph.ys[id] - pt.y;
+			float d2 = dx * dx + dy * dy;
+			if (d2 < best_d2 || (d2 == best_d2 && (best == -1 || id < best))) {
+				best = id;
+				best_d2 = d2;
+			}
+		});
+	}
+	return best;
+}
+
+std::vector<int> NavMesh::NodeGrid::KNearest(const Graph& graph, sf::Vector2f pt, int k) const {
+
+	std::vector<int> found;
+	if (cols == 0 || k <= 0) return found;
+
+	sf::Vector2f clamped(std::min(max_x, std::max(min_x, pt.x)), std::min(max_y, std::max(min_y, pt.y)));
+	int col = Col(clamped.x);
+	int row = Row(clamped.y);
+
+	// the k best so far, farthest on top 
+	std::priority_queue<std::pair<float, int>> best;
+	for (int ring = 0; ring < std::max(cols, rows); ++ring) {
+
+		float bound = RingBound(clamped, col, row, ring);
+		if ((int)best.size() == k && bound * bound > best.top().first) break;
+
+		VisitRing(col, row, ring, [&](int id) {
+			float dx = graph.xs[id] - pt.x;
+			float dy = graph.ys[id] - pt.y;
+			std::pair<float, int> entry(dx * dx + dy * dy, id);
+			if ((int)best.size() < k) best.push(entry);
+			else if (entry < best.top()) {
+				best.pop();
+				best.push(entry);
+			}
+		});
+	}
+
+	found.resize(best.size());
+	for (int i = (int)found.size() - 1; i >= 0; --i) {
+		found[i] = best.top().second;
+		best.pop();
+	}
+	return found;
+}
+
+std::vector<int> NavMesh::NodeGrid::Within(const Graph& graph, sf::Vector2f pt, float radius) const {
+
+	std::vector<int> found;
+	if (cols == 0 || !(radius >= 0.0f)) return found;
+	if (pt.x + radius < min_x || pt.x - radius > max_x || pt.y + radius < min_y || pt.y - radius > max_y) return found;
+
+	float r2 = radius * radius;
+	for (int r = Row(pt.y - radius); r <= Row(pt.y + radius); ++r) {
+		for (int c = Col(pt.x - radius); c <= Col(pt.x + radius); ++c) {
+			for (int id = head[r * cols + c]; id != -1; id = next[id]) {
+				float dx = graph.xs[id] - pt.x;
+				float dy = graph.ys[id] - pt.y;
+				if (dx * dx + dy * dy <= r2) found.push_back(id);
+			}
+		}
+	}
+	return found;
+}
+
+
+namespace {
+
+	// Dijkstra from source over the whole graph; unreached nodes are left at UNREACHABLE 
+	void LandmarkSearch(const NavMesh::Graph& graph, int source, Dijkstra& search, std::vector<float>& dist) {
+
+		search.Reset(graph.NodeCount());
+		search.Relax(source, 0.0f, -1);
+		search.Run(graph.offsets.data(), graph.neighbours.data(), graph.weights.data());
+		for (int i = 0; i < graph.NodeCount(); ++i) dist[i] = search.Reached(i) ? search.Dist(i) : NavMesh::LandmarkTable::UNREACHABLE;
+	}
+}
+
+void NavMesh::BuildLandmarks(int count) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	landmark_count = count;
+	landmarks = LandmarkTable();
+	int node_count = graph.NodeCount();
+	if (count <= 0 || node_count == 0) return;
+	count = std::min(count, node_count);
+
+	std::vector<float> dist(node_count);
+	Dijkstra search;
+
+	// the landmarks are spread over the largest connected part of the mesh; nodes elsewhere are only ever bounded by straight lines 
+	std::vector<int> component(node_count, -1), stack;
+	int largest = 0, largest_size = 0;
+	for (int seed = 0, c = 0; seed < node_count; ++seed) {
+		if (component[seed] != -1) continue;
+		int size = 0;
+		component[seed] = c;
+		stack.push_back(seed);
+		while (!stack.empty()) {
+			int u = stack.back();
+			stack.pop_back();
+			++size;
+			for (int k = graph.Begin(u); k < graph.End(u); ++k) {
+				if (component[graph.neighbours[k]] != -1) continue;
+				component[graph.neighbours[k]] = c;
+				stack.push_back(graph.neighbours[k]);
+			}
+		}
+		if (size > largest_size) {
+			largest = seed;
+			largest_size = size;
+		}
+		++c;
+	}
+
+	// farthest selection: the first landmark is the node farthest from the part's first node, every next one the node farthest from its 
+	// nearest landmark 
+	landmarks.count = count;
+	landmarks.distances.assign((size_t)node_count * count, LandmarkTable::UNREACHABLE);
+	LandmarkSearch(graph, largest, search, dist);
+	std::vector<float> nearest = dist;
+
+	for (int k = 0; k < count; ++k) {
+
+		int next = (int)(std::max_element(nearest.begin(), nearest.end()) - nearest.begin());
+		landmarks.landmarks.push_back(next);
+		LandmarkSearch(graph, next, search, dist);
+
+		for (int i = 0; i < node_count; ++i) {
+			landmarks.distances[(size_t)i * count + k] = dist[i];
+			if (dist[i] != LandmarkTable::UNREACHABLE && (k == 0 || dist[i] < nearest[i])) nearest[i] = dist[i];
+		}
+	}
+
+	timings.landmarks_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	METRICS_OBSERVE(LANDMARKS_US, timings.landmarks_us);
 }
 
 
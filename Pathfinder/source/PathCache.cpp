@@ -0,0 +1,103 @@
+#include "PathCache.h"
+
+
+void PathCache::Unlink(int slot) {
+	Entry& entry = entries[slot];
+	if (entry.prev != -1) entries[entry.prev].next = entry.next;
+	else head = entry.next;
+	if (entry.next != -1) entries[entry.next].prev = entry.prev;
+	else tail = entry.prev;
+	entry.prev = entry.next = -1;
+}
+
+void PathCache::PushFront(int slot) {
+	entries[slot].prev = -1;
+	entries[slot].next = head;
+	if (head != -1) entries[head].prev = slot;
+	head = slot;
+	if (tail == -1) tail = slot;
+}
+
+
+void PathCache::Clear() {
+	entries.clear();
+	index.clear();
+	head = tail = -1;
+}
+
+void PathCache::Sync(const NavMesh& mesh) {
+
+	if (synced_mesh == &mesh && version == mesh.GetVersion()) return;
+
+	if (synced_mesh != &mesh || mesh.GetRebuildVersion() > version) {
+		stats.invalidations += (long long)index.size();
+		Clear();
+	}
+	else {
+		// the survivors are compacted to the front of entries, keeping their recency order 
+		std::vector<Entry> kept;
+		kept.reserve(entries.size());
+		for (int slot = head; slot != -1; slot = entries[slot].next) {
+			const std::vector<int>& path = entries[slot].path;
+			bool valid = !path.empty();
+			for (size_t i = 0; valid && i < path.size(); ++i) valid = mesh.GetNodeVersion(path[i]) <= version;
+			if (!valid) {
+				++stats.invalidations;
+				continue;
+			}
+			kept.push_back(std::move(entries[slot]));
+		}
+
+		entries.swap(kept);
+		index.clear();
+		head = entries.empty() ? -1 : 0;
+		tail = (int)entries.size() - 1;
+		for (int slot = 0; slot < (int)entries.size(); ++slot) {
+			entries[slot].prev = slot - 1;
+			entries[slot].next = slot + 1 < (int)entries.size() ? slot + 1 : -1;
+			index[entries[slot].key] = slot;
+		}
+	}
+
+	synced_mesh = &mesh;
+	version = mesh.GetVersion();
+}
+
+std::vector<int> PathCache::Find(const NavMesh& mesh, int start_id, int destination_id, A_Star::SearchContext& context) {
+
+	Sync(mesh);
+
+	unsigned long long key = Key(start_id, destination_id);
+	auto found = index.find(key);
+	if (found != index.end()) {
+		++stats.hits;
+		if (found->second != head) {
+			Unlink(found->second);
+			PushFront(found->second);
+		}
+		return entries[found->second].path;
+	}
+
+	++stats.misses;
+	std::vector<int> path = A_Star::Find(mesh, start_id, destination_id, context);
+	if (capacity == 0) return path;
+
+	// a full cache reuses the slot of its least recently used entry 
+	int slot;
+	if (index.size() >= capacity) {
+		slot = tail;
+		Unlink(slot);
+		index.erase(entries[slot].key);
+		++stats.evictions;
+	}
+	else {
+		slot = (int)entries.size();
+		entries.emplace_back();
+	}
+
+	entries[slot].key = key;
+	entries[slot].path = path;
+	index[key] = slot;
+	PushFront(slot);
+	return path;
+}